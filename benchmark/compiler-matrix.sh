@@ -0,0 +1,91 @@
+#!/bin/bash
+set -euo pipefail
+
+# Build throughput-benchmark with each toolchain in test/toolchain, at each optimization level
+# and with each EG_ASSERT_STRATEGY, run it, and print a table of throughput beside the size of the code of each hot path.
+# Usage: compiler-matrix.sh [WORK_DIR]
+# The compilers are g++ and clang++ unless GCC_CXX or CLANG_CXX name others; a toolchain whose compiler is missing is skipped.
+# Throughput is in millions of positions or tokens per second, and sizes are in bytes.
+
+PROJECT_DIR=$(cd "$(dirname "$0")/.."; pwd)
+WORK_DIR="${1:-$(pwd)/compiler-matrix}"
+NUM_CPUS="$(nproc)"
+
+mkdir -p "${WORK_DIR}"
+
+LEVELS=(O2 O3 Os)
+STRATEGIES=(TRAP PREVENTION LOG_AND_CONTINUE)
+
+# The hot paths, as named by throughput-benchmark, and the functions which implement them, demangled;
+# clones of a function made by the optimizer are counted with it.
+HOT_PATHS=(number-to-letter find-invalid-position positions-to-letters sanitize-token)
+HOT_FUNCTIONS=(
+    '^\(anonymous namespace\)::convert_one_by_one\('
+    '^find_invalid_position\(std::span<int const, [0-9]+ul>\)'
+    '^positions_to_letters\(std::span<int const, [0-9]+ul>, std::span<char, [0-9]+ul>\)'
+    '^sanitize_token\('
+)
+
+# @return the total size of the functions whose demangled names match a pattern
+code_size() {
+    local program="$1"
+    local pattern="$2"
+    local total=0
+    while read -r _ size _ name; do
+        if [[ "${name}" =~ ${pattern} ]]; then
+            total=$((total + 16#${size}))
+        fi
+    done < <(nm --demangle --print-size --defined-only "${program}")
+    echo "${total}"
+}
+
+print_row() {
+    printf '%-8s %-6s %-17s' "$1" "$2" "$3"
+    shift 3
+    printf ' %24s' "$@"
+    printf '\n'
+}
+
+print_row toolchain level strategy "${HOT_PATHS[@]/%/-mps}" "${HOT_PATHS[@]/%/-bytes}"
+
+for toolchain_file in "${PROJECT_DIR}"/test/toolchain/*.cmake; do
+    toolchain="$(basename "${toolchain_file}" .cmake)"
+    case "${toolchain}" in
+        gcc) compiler="${GCC_CXX:-g++}" ;;
+        clang) compiler="${CLANG_CXX:-clang++}" ;;
+        *) compiler="${toolchain}" ;;
+    esac
+    if ! command -v "${compiler}" > /dev/null; then
+        echo "Skipping ${toolchain}: ${compiler} not found" >&2
+        continue
+    fi
+
+    for level in "${LEVELS[@]}"; do
+        for strategy in "${STRATEGIES[@]}"; do
+            build_dir="${WORK_DIR}/${toolchain}-${level}-${strategy}"
+            cmake \
+                -DCMAKE_BUILD_TYPE=Release \
+                -DCMAKE_CXX_COMPILER="${compiler}" \
+                -DCMAKE_CXX_FLAGS_RELEASE="-${level}" \
+                -DCMAKE_TOOLCHAIN_FILE="${toolchain_file}" \
+                -DEG_ASSERT_STRATEGY="${strategy}" \
+                -DEG_FREESTANDING=OFF \
+                -S "${PROJECT_DIR}" \
+                -B "${build_dir}" \
+                > "${build_dir}.log" 2>&1 || { echo "Failed to configure ${build_dir}; see ${build_dir}.log" >&2; exit 1; }
+            cmake --build "${build_dir}" --target throughput-benchmark -- -j "${NUM_CPUS}" \
+                >> "${build_dir}.log" 2>&1 || { echo "Failed to build ${build_dir}; see ${build_dir}.log" >&2; exit 1; }
+
+            program="${build_dir}/benchmark/throughput-benchmark"
+            throughputs=()
+            while read -r _ value; do
+                throughputs+=("${value}")
+            done < <("${program}")
+            sizes=()
+            for pattern in "${HOT_FUNCTIONS[@]}"; do
+                sizes+=("$(code_size "${program}" "${pattern}")")
+            done
+            print_row "${toolchain}" "${level}" "${strategy}" "${throughputs[@]}" "${sizes[@]}"
+        done
+    done
+done
@@ -0,0 +1,244 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file A generator of input for batch mode, resembling real use, for training and benchmarking the program.
+
+#include "echo.h"
+#include "letter.h"
+#include "options.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <span>
+#include <string_view>
+
+#include <fmt/format.h>
+
+namespace {
+  using namespace std::literals::string_view_literals;
+
+  enum class corpus_format { text, ndjson, csv, binary };
+
+  struct corpus_options {
+    corpus_format format{corpus_format::text};
+
+    /// the corpus ends with the first line to reach this size
+    std::uint64_t num_bytes{1U << 20U};
+
+    /// a different seed gives a different corpus of the same kind, e.g. to benchmark on other input than was trained on
+    std::uint64_t seed{1};
+
+    char const* output{nullptr};
+  };
+
+  auto parse_options(std::span<char*> args) -> std::optional<corpus_options>
+  {
+    corpus_options options;
+    option_parser parser{args};
+    while (parser) {
+      if (auto const* const format{parser.value("--format"sv)}) {
+        auto const argument{std::string_view{format}};
+        if (argument == "text"sv) {
+          options.format = corpus_format::text;
+        }
+        else if (argument == "ndjson"sv) {
+          options.format = corpus_format::ndjson;
+        }
+        else if (argument == "csv"sv) {
+          options.format = corpus_format::csv;
+        }
+        else if (argument == "binary"sv) {
+          options.format = corpus_format::binary;
+        }
+        else {
+          fmt::print(stderr, "Unrecognized format, {}\n", quote_input(argument));
+          return std::nullopt;
+        }
+      }
+      else if (auto const* const num_bytes{parser.value("--bytes"sv)}) {
+        auto const argument{std::string_view{num_bytes}};
+        auto [ptr, ec] = std::from_chars(argument.data(), argument.data() + argument.size(), options.num_bytes);
+        if (ec != std::errc{} || ptr != argument.data() + argument.size() || options.num_bytes == 0) {
+          fmt::print(stderr, "Unrecognized size, {}\n", quote_input(argument));
+          return std::nullopt;
+        }
+      }
+      else if (auto const* const seed{parser.value("--seed"sv)}) {
+        auto const argument{std::string_view{seed}};
+        auto [ptr, ec] = std::from_chars(argument.data(), argument.data() + argument.size(), options.seed);
+        if (ec != std::errc{} || ptr != argument.data() + argument.size()) {
+          fmt::print(stderr, "Unrecognized seed, {}\n", quote_input(argument));
+          return std::nullopt;
+        }
+      }
+      else if (auto const* const output{parser.value("--output"sv)}) {
+        options.output = output;
+      }
+      else {
+        fmt::print(stderr, "Unrecognized option, {}\n", quote_input(parser.positional()));
+        return std::nullopt;
+      }
+    }
+    if (parser.failed()) {
+      return std::nullopt;
+    }
+    if (options.output == nullptr) {
+      fmt::print(stderr, "Usage: make-corpus [--format=text|ndjson|csv|binary] [--bytes N] [--seed N] --output FILE\n");
+      return std::nullopt;
+    }
+    return options;
+  }
+
+  /// bad tokens, each breaking a different End User Contract check
+  constexpr std::string_view bad_tokens[]{"0"sv, "27"sv, "1X"sv, "-3"sv, "99999999999"sv, "x"sv, "0x5"sv};
+
+  /// @brief A source of tokens, the same on every run with the same seed, of which about one in a hundred is bad.
+  class token_source {
+  public:
+    explicit token_source(std::uint64_t seed)
+        : engine_{seed}
+    {
+    }
+
+    /// @return whether the next token is bad
+    auto bad() -> bool
+    {
+      return std::uniform_int_distribution{0, 99}(engine_) == 0;
+    }
+
+    auto bad_token() -> std::string_view
+    {
+      return bad_tokens[std::uniform_int_distribution<std::size_t>{0, std::size(bad_tokens) - 1}(engine_)];
+    }
+
+    auto number() -> int
+    {
+      return std::uniform_int_distribution{min_number, max_number}(engine_);
+    }
+
+    /// @return the number of copies in a run, or zero for a lone position
+    auto run_length() -> int
+    {
+      return std::uniform_int_distribution{0, 24}(engine_) == 0 ? std::uniform_int_distribution{2, 9}(engine_) : 0;
+    }
+
+    auto line_length() -> int
+    {
+      return std::uniform_int_distribution{1, 16}(engine_);
+    }
+
+  private:
+    std::mt19937_64 engine_;
+  };
+
+  /// @brief Append a line of whitespace-separated tokens, e.g. `8 5 12x2 15`.
+  void append_text_line(fmt::memory_buffer& line, token_source& source)
+  {
+    for (auto num_tokens{source.line_length()}, token{0}; token != num_tokens; ++token) {
+      if (token != 0) {
+        line.push_back(' ');
+      }
+      if (source.bad()) {
+        fmt::format_to(std::back_inserter(line), "{}", source.bad_token());
+      }
+      else if (auto const run_length{source.run_length()}) {
+        fmt::format_to(std::back_inserter(line), "{}x{}", run_length, source.number());
+      }
+      else {
+        fmt::format_to(std::back_inserter(line), "{}", source.number());
+      }
+    }
+    line.push_back('\n');
+  }
+
+  /// @brief Append an object with the position in member `n`, e.g. `{"id":7,"n":3}`.
+  void append_ndjson_line(fmt::memory_buffer& line, token_source& source, std::uint64_t line_number)
+  {
+    if (source.bad()) {
+      fmt::format_to(std::back_inserter(line), "{{\"id\":{},\"n\":\"{}\"}}\n", line_number, source.bad_token());
+    }
+    else {
+      fmt::format_to(std::back_inserter(line), "{{\"id\":{},\"n\":{}}}\n", line_number, source.number());
+    }
+  }
+
+  /// @brief Append a record with the position in the second field, e.g. `7,3,"a, b"`.
+  void append_csv_line(fmt::memory_buffer& line, token_source& source, std::uint64_t line_number)
+  {
+    if (source.bad()) {
+      fmt::format_to(std::back_inserter(line), "{},{},\"a, b\"\n", line_number, source.bad_token());
+    }
+    else {
+      fmt::format_to(std::back_inserter(line), "{},{},note\n", line_number, source.number());
+    }
+  }
+
+  /// @brief Append a block of bytes, one position each, some of which may be out of range.
+  void append_binary_block(fmt::memory_buffer& block, token_source& source)
+  {
+    constexpr auto block_size{4096};
+    for (auto i{0}; i != block_size; ++i) {
+      block.push_back(char(source.bad() ? max_number + 1 : source.number()));
+    }
+  }
+}
+
+/// @brief Write a corpus of the given format and size, the same each time for a given seed, to a file.
+auto main(int argc, char* argv[]) -> int
+{
+  auto const options{parse_options(std::span{argv + 1, std::size_t(argc) - 1U})};
+  if (!options) {
+    return EXIT_FAILURE;
+  }
+
+  auto* const output{std::fopen(options->output, "wb")};
+  if (output == nullptr) {
+    fmt::print(stderr, "Failed to open output file, {}\n", quote_input(options->output));
+    return EXIT_FAILURE;
+  }
+
+  token_source source{options->seed};
+  fmt::memory_buffer line;
+  for (std::uint64_t num_bytes{0}, line_number{1}; num_bytes < options->num_bytes; ++line_number) {
+    line.clear();
+    switch (options->format) {
+      case corpus_format::text:
+        append_text_line(line, source);
+        break;
+      case corpus_format::ndjson:
+        append_ndjson_line(line, source, line_number);
+        break;
+      case corpus_format::csv:
+        append_csv_line(line, source, line_number);
+        break;
+      case corpus_format::binary:
+        append_binary_block(line, source);
+        break;
+    }
+    std::fwrite(line.data(), 1, line.size(), output);
+    num_bytes += line.size();
+  }
+
+  auto const failed{std::ferror(output) != 0};
+  if (std::fclose(output) != 0 || failed) {
+    fmt::print(stderr, "Failed to write output file, {}\n", quote_input(options->output));
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,164 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file A benchmark of the time taken to start, run and exit a program, as seen by its caller.
+
+#include "echo.h"
+#include "options.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <fmt/printf.h>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+namespace {
+  using namespace std::literals::string_view_literals;
+
+  /// runs before those which are measured, so that the program and its libraries are in the page cache
+  constexpr std::uint64_t num_warmup_runs{16};
+
+  struct benchmark_options {
+    std::uint64_t num_runs{1000};
+
+    /// runs which exit with failure, as batch runs over input with bad tokens do, are measured like the rest
+    bool allow_failure{false};
+
+    /// the program to run and its arguments
+    std::span<char*> command;
+  };
+
+  auto parse_options(std::span<char*> args) -> std::optional<benchmark_options>
+  {
+    benchmark_options options;
+    option_parser parser{args};
+    while (parser) {
+      if (auto const* const num_runs{parser.value("--runs"sv)}) {
+        auto const argument{std::string_view{num_runs}};
+        auto [ptr, ec] = std::from_chars(argument.data(), argument.data() + argument.size(), options.num_runs);
+        if (ec != std::errc{} || ptr != argument.data() + argument.size() || options.num_runs == 0) {
+          fmt::print(stderr, "Unrecognized run count, {}\n", quote_input(argument));
+          return std::nullopt;
+        }
+      }
+      else if (parser.flag("--allow-failure"sv)) {
+        options.allow_failure = true;
+      }
+      else {
+        // Everything from the first positional argument on is the command, still followed by the null of `argv`.
+        auto const* const program{parser.positional()};
+        options.command = args.last(std::size_t(args.end() - std::find(args.begin(), args.end(), program)));
+        break;
+      }
+    }
+    if (parser.failed()) {
+      return std::nullopt;
+    }
+    if (options.command.empty()) {
+      fmt::print(stderr, "Usage: startup-benchmark [--runs N] [--allow-failure] PROGRAM [ARGUMENT...]\n");
+      return std::nullopt;
+    }
+    return options;
+  }
+
+  /// @brief Run the command once, with its output discarded, and wait for it to exit.
+  /// @return the time from spawning to exit, or nothing if the command could not be run or failed
+  auto run_once(benchmark_options const& options, posix_spawn_file_actions_t const& actions)
+      -> std::optional<std::chrono::nanoseconds>
+  {
+    auto const start{std::chrono::steady_clock::now()};
+    pid_t pid;
+    if (auto const error{::posix_spawn(&pid, options.command[0], &actions, nullptr, options.command.data(), environ)};
+        error != 0) {
+      fmt::print(stderr, "Failed to run program, '{}': {}\n", options.command[0], std::strerror(error));
+      return std::nullopt;
+    }
+    int status;
+    while (::waitpid(pid, &status, 0) == -1) {
+      if (errno != EINTR) {
+        fmt::print(stderr, "Failed to wait for program: {}\n", std::strerror(errno));
+        return std::nullopt;
+      }
+    }
+    auto const finish{std::chrono::steady_clock::now()};
+
+    if (!WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS && !options.allow_failure)) {
+      fmt::print(stderr, "Program failed, '{}'\n", options.command[0]);
+      return std::nullopt;
+    }
+    return finish - start;
+  }
+
+  /// @return the smallest duration of which at least `fraction` of the sorted durations are no greater
+  auto percentile(std::span<std::chrono::nanoseconds const> sorted, double fraction)
+  {
+    auto const rank{std::size_t(std::ceil(fraction * double(sorted.size())))};
+    return std::uint64_t(sorted[std::clamp(rank, std::size_t{1}, sorted.size()) - 1].count());
+  }
+}
+
+/// @brief Run a program many times and print percentiles of the time from spawning it to its exit.
+/// @note The results are printed as `name value` lines, with times in nanoseconds.
+auto main(int argc, char* argv[]) -> int
+{
+  auto const options{parse_options(std::span{argv + 1, std::size_t(argc) - 1U})};
+  if (!options) {
+    return EXIT_FAILURE;
+  }
+
+  posix_spawn_file_actions_t actions;
+  ::posix_spawn_file_actions_init(&actions);
+  ::posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+  ::posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+  std::vector<std::chrono::nanoseconds> durations;
+  durations.reserve(options->num_runs);
+  for (std::uint64_t run{0}; run != num_warmup_runs + options->num_runs; ++run) {
+    auto const duration{run_once(*options, actions)};
+    if (!duration) {
+      ::posix_spawn_file_actions_destroy(&actions);
+      return EXIT_FAILURE;
+    }
+    if (run >= num_warmup_runs) {
+      durations.push_back(*duration);
+    }
+  }
+  ::posix_spawn_file_actions_destroy(&actions);
+
+  std::sort(durations.begin(), durations.end());
+  fmt::print("runs {}\n", options->num_runs);
+  fmt::print("min-ns {}\n", durations.front().count());
+  fmt::print("p50-ns {}\n", percentile(durations, .5));
+  fmt::print("p90-ns {}\n", percentile(durations, .9));
+  fmt::print("p99-ns {}\n", percentile(durations, .99));
+  fmt::print("p99.9-ns {}\n", percentile(durations, .999));
+  fmt::print("max-ns {}\n", durations.back().count());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,175 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file A benchmark of the throughput of the hot paths of conversion, within one process and on one thread.
+
+#include "bulk.h"
+#include "echo.h"
+#include "letter.h"
+#include "options.h"
+#include "token.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/printf.h>
+
+namespace {
+  using namespace std::literals::string_view_literals;
+
+  struct benchmark_options {
+    std::uint64_t num_positions{1U << 22U};
+
+    /// the best of the repeats is reported, as the others were slowed by something else
+    std::uint64_t num_repeats{10};
+  };
+
+  auto parse_count(std::string_view argument, std::uint64_t& count) -> bool
+  {
+    auto [ptr, ec] = std::from_chars(argument.data(), argument.data() + argument.size(), count);
+    if (ec != std::errc{} || ptr != argument.data() + argument.size() || count == 0) {
+      fmt::print(stderr, "Unrecognized count, {}\n", quote_input(argument));
+      return false;
+    }
+    return true;
+  }
+
+  auto parse_options(std::span<char*> args) -> std::optional<benchmark_options>
+  {
+    benchmark_options options;
+    option_parser parser{args};
+    while (parser) {
+      if (auto const* const num_positions{parser.value("--positions"sv)}) {
+        if (!parse_count(num_positions, options.num_positions)) {
+          return std::nullopt;
+        }
+      }
+      else if (auto const* const num_repeats{parser.value("--repeats"sv)}) {
+        if (!parse_count(num_repeats, options.num_repeats)) {
+          return std::nullopt;
+        }
+      }
+      else {
+        fmt::print(stderr, "Usage: throughput-benchmark [--positions N] [--repeats N]\n");
+        return std::nullopt;
+      }
+    }
+    if (parser.failed()) {
+      return std::nullopt;
+    }
+    return options;
+  }
+
+  /// @brief Keep the compiler from discarding work whose result is not otherwise used.
+  template<typename T>
+  void keep(T const& result)
+  {
+    asm volatile("" : : "r,m"(result) : "memory");
+  }
+
+  // The hot paths which are not already functions of the library are kept out of line,
+  // so that the size of their code can be read from the symbol table.
+
+  /// @brief Convert positions one at a time, as code which does not use the bulk functions would.
+  /// @pre every position is in the range [1..26]
+  [[gnu::noinline]] void convert_one_by_one(std::span<int const> positions, std::span<char> letters)
+  {
+    for (std::size_t i{0}; i != positions.size(); ++i) {
+      letters[i] = number_to_letter(positions[i]);
+    }
+  }
+
+  /// @brief Sanitize tokens, as batch mode does once it has split its input.
+  /// @return the number of letters which the tokens denote
+  [[gnu::noinline]] auto sanitize_tokens(std::span<std::string_view const> tokens) -> std::size_t
+  {
+    std::size_t num_letters{0};
+    for (auto const token : tokens) {
+      num_letters += sanitize_token(token).letters.length;
+    }
+    return num_letters;
+  }
+
+  /// @brief Time a function over several repeats.
+  /// @return the throughput of the fastest repeat, in millions of items per second
+  template<typename Function>
+  auto measure(std::uint64_t num_repeats, std::size_t num_items, Function function) -> std::uint64_t
+  {
+    auto best{std::chrono::nanoseconds::max()};
+    for (std::uint64_t repeat{0}; repeat != num_repeats; ++repeat) {
+      auto const start{std::chrono::steady_clock::now()};
+      function();
+      best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start));
+    }
+    return std::uint64_t(double(num_items) * 1e3 / double(std::max(best.count(), std::int64_t{1})));
+  }
+}
+
+/// @brief Measure the throughput of each hot path, on input which is the same on every run.
+/// @note The results are printed as `name value` lines, in millions of positions or tokens per second.
+auto main(int argc, char* argv[]) -> int
+{
+  auto const options{parse_options(std::span{argv + 1, std::size_t(argc) - 1U})};
+  if (!options) {
+    return EXIT_FAILURE;
+  }
+
+  // Positions, all of them valid, so that validation reads every one of them
+  std::mt19937_64 engine;
+  std::vector<int> positions(options->num_positions);
+  std::generate(positions.begin(), positions.end(), [&] {
+    return std::uniform_int_distribution{min_number, max_number}(engine);
+  });
+  std::vector<char> letters(positions.size());
+
+  // Tokens of batch input, of which about one in a hundred is bad
+  std::string text;
+  for (std::size_t i{0}; i != positions.size(); ++i) {
+    fmt::format_to(std::back_inserter(text), "{} ", i % 100 == 99 ? max_number + 1 : positions[i]);
+  }
+  std::vector<std::string_view> tokens;
+  tokens.reserve(positions.size());
+  for (auto rest{std::string_view{text}}; !rest.empty();) {
+    auto const end{rest.find(' ')};
+    tokens.push_back(rest.substr(0, end));
+    rest.remove_prefix(end + 1);
+  }
+
+  fmt::print("number-to-letter-mps {}\n", measure(options->num_repeats, positions.size(), [&] {
+               convert_one_by_one(positions, letters);
+               keep(letters.data());
+             }));
+  fmt::print("find-invalid-position-mps {}\n", measure(options->num_repeats, positions.size(), [&] {
+               keep(find_invalid_position(positions));
+             }));
+  fmt::print("positions-to-letters-mps {}\n", measure(options->num_repeats, positions.size(), [&] {
+               positions_to_letters(positions, letters);
+               keep(letters.data());
+             }));
+  fmt::print("sanitize-token-mps {}\n", measure(options->num_repeats, tokens.size(), [&] {
+               keep(sanitize_tokens(tokens));
+             }));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,37 @@
+#!/bin/bash
+set -euo pipefail
+
+# Run the program over a representative workload, so that an instrumented build records where its time goes.
+# Usage: train.sh PROGRAM CORPUS_DIR
+# CORPUS_DIR holds text, ndjson, csv and binary files written by make-corpus.
+
+PROGRAM="$1"
+CORPUS_DIR="$2"
+
+# Run the program with its output discarded;
+# the corpus holds bad tokens, so exiting with failure is expected, but being killed is not.
+run() {
+    local status=0
+    "${PROGRAM}" "$@" > /dev/null 2>&1 || status=$?
+    if [ "${status}" -gt 1 ]; then
+        echo "Training run failed with status ${status}: $*" >&2
+        exit 1
+    fi
+}
+
+# Single conversions, good and bad
+for argument in 1 13 26 0 27 1X --help; do
+    run "${argument}"
+done
+run
+
+# Batch mode, in proportion to how it is used
+run --batch "${CORPUS_DIR}/text"
+run --batch --rle "${CORPUS_DIR}/text"
+run --batch --on-error=placeholder "${CORPUS_DIR}/text"
+run --batch --histogram "${CORPUS_DIR}/text"
+run --batch --format=ndjson "${CORPUS_DIR}/ndjson"
+run --batch --format=ndjson --histogram "${CORPUS_DIR}/ndjson"
+run --batch --csv-column 2 "${CORPUS_DIR}/csv"
+run --batch --format=binary "${CORPUS_DIR}/binary"
+run --batch --format=binary --trusted "${CORPUS_DIR}/binary"
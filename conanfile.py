@@ -2,5 +2,5 @@ from conans import ConanFile, CMake
 
 class WssConan(ConanFile):
     settings = "os", "compiler", "build_type", "arch"
-    requires = "fmt/7.1.3"
+    requires = "fmt/7.1.3", "zlib/1.2.11", "zstd/1.5.0"
     generators = "cmake", "gcc", "txt"
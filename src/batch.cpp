@@ -0,0 +1,1714 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Batch mode: converting a stream of positions rather than a single argument.
+
+#include "batch.h"
+#include "binary.h"
+#include "cache.h"
+#include "checkpoint.h"
+#include "csv.h"
+#include "echo.h"
+#include "file.h"
+#include "hash.h"
+#include "histogram.h"
+#include "index.h"
+#include "input.h"
+#include "json.h"
+#include "log_queue.h"
+#include "options.h"
+#include "token.h"
+#include "tuning.h"
+#include "writer.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <barrier>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(EG_HAVE_INOTIFY)
+#include "follow.h"
+#endif
+
+namespace {
+  using namespace std::literals::string_view_literals;
+
+  /// @brief the syntax of each line of input and output
+  enum class line_format {
+    /// whitespace-separated tokens in; letters out
+    text,
+
+    /// JSON objects holding a token in one field; JSON objects holding a letter or error out
+    ndjson,
+
+    /// CSV records holding a token in one column; the same records with the token converted out
+    csv,
+
+    /// one byte per position in; one line of letters out
+    binary,
+  };
+
+  /// @brief the settings of a batch run, sanitized from the program arguments
+  struct batch_options {
+    /// null-terminated name of the file to read, or null for stdin
+    char const* input_path{nullptr};
+
+    /// null-terminated name of the file to write letters to, or null for stdout
+    char const* output_path{nullptr};
+
+    /// null-terminated name of the file to write diagnostics to, or null for stderr
+    char const* error_log_path{nullptr};
+
+    /// null-terminated name of the file to write a sparse line index to, or null
+    char const* index_path{nullptr};
+
+    /// null-terminated name of a file in which to record progress, or null
+    char const* checkpoint_path{nullptr};
+
+    /// continue from the checkpoint, if there is one
+    bool resume{false};
+
+    /// if not zero, convert only shard `shard_index` of `shard_count` line-aligned parts of the input, counting from 1
+    std::uint64_t shard_index{0};
+
+    /// the number of shards into which the input is divided, or zero
+    std::uint64_t shard_count{0};
+
+    /// wait for lines to be appended to the input file instead of stopping at its end
+    bool follow{false};
+
+    /// null-terminated name of a directory in which to store and find the results of runs, or null
+    char const* cache_directory{nullptr};
+
+    /// if set, print what this line produced in an earlier run instead of converting
+    std::optional<std::uint64_t> lookup;
+
+    /// the syntax of each line
+    line_format format{line_format::text};
+
+    /// in NDJSON format, the name of the field holding the token
+    std::string_view field{"n"};
+
+    /// in CSV format, the column holding the token, counting from 1
+    std::size_t csv_column{0};
+
+    /// in CSV format, pass the first record through untouched
+    bool csv_header{false};
+
+    /// write runs of four or more letters as, e.g., "5xC"
+    bool rle_output{false};
+
+    /// write only how many times each letter and violation occurred
+    bool histogram{false};
+
+    /// in binary format, the producer guarantees that every position is in range
+    bool trusted{false};
+
+    /// the most bytes of a bad token to echo in its diagnostic
+    std::size_t echo_limit{default_echo_limit};
+
+    /// what to do with a bad token, once it has been reported
+    error_policy on_error{error_policy::skip};
+
+    /// the number of threads which may work on the input at once
+    unsigned num_threads{unsigned(tuning{}.num_threads)};
+
+    /// the number of threads was chosen by the user rather than by tuning
+    bool num_threads_given{false};
+
+    /// the bytes of input which each thread tallies at a time with `histogram`
+    std::size_t chunk_size{tuning{}.chunk_size};
+
+    /// the size of the buffers into which input is read and output is written
+    std::size_t buffer_size{tuning{}.buffer_size};
+
+    /// input files smaller than this are worked on by one thread
+    std::uint64_t parallel_threshold{tuning{}.parallel_threshold};
+
+    /// null-terminated name of the tuning file, or null for the default
+    char const* tuning_path{nullptr};
+
+    /// instead of converting, measure the speed of different tuning parameters and save the fastest
+    bool calibrate{false};
+  };
+
+  /// @brief Sanitize the options passed to batch mode.
+  /// @return the options, or nothing if the End User Contract was violated
+  auto parse_options(std::span<char*> args) -> std::optional<batch_options>
+  {
+    batch_options options;
+    option_parser parser{args};
+    while (parser) {
+      if (parser.flag("--rle"sv)) {
+        options.rle_output = true;
+      }
+      else if (parser.flag("--histogram"sv)) {
+        options.histogram = true;
+      }
+      else if (parser.flag("--trusted"sv)) {
+        options.trusted = true;
+      }
+      else if (auto const* const output_path{parser.value("--output"sv)}) {
+        options.output_path = output_path;
+      }
+      else if (auto const* const error_log_path{parser.value("--error-log"sv)}) {
+        options.error_log_path = error_log_path;
+      }
+      else if (auto const* const shard{parser.value("--shard"sv)}) {
+        auto const argument{std::string_view{shard}};
+        auto const* const last{argument.data() + argument.size()};
+        auto const [slash, index_ec] = std::from_chars(argument.data(), last, options.shard_index);
+        auto const [end, count_ec] = slash != last && *slash == '/'
+            ? std::from_chars(slash + 1, last, options.shard_count)
+            : std::from_chars_result{slash, std::errc::invalid_argument};
+        if (index_ec != std::errc{} || count_ec != std::errc{} || end != last) {
+          fmt::print(stderr, "Unrecognized shard, {}\n", quote_input(argument));
+          return std::nullopt;
+        }
+        if (options.shard_index < 1 || options.shard_index > options.shard_count) {
+          fmt::print(stderr, "Out-of-range shard, {}\n", quote_input(argument));
+          return std::nullopt;
+        }
+      }
+      else if (auto const* const checkpoint_path{parser.value("--checkpoint"sv)}) {
+        options.checkpoint_path = checkpoint_path;
+      }
+      else if (parser.flag("--calibrate"sv)) {
+        options.calibrate = true;
+      }
+      else if (auto const* const tuning_path{parser.value("--tuning"sv)}) {
+        options.tuning_path = tuning_path;
+      }
+      else if (parser.flag("--resume"sv)) {
+        options.resume = true;
+      }
+      else if (auto const* const follow_path{parser.value("--follow"sv)}) {
+        if (options.input_path != nullptr) {
+          fmt::print(stderr, "Unexpected argument, {}\n", quote_input(follow_path));
+          return std::nullopt;
+        }
+        options.input_path = follow_path;
+        options.follow = true;
+      }
+      else if (auto const* const cache_directory{parser.value("--cache"sv)}) {
+        options.cache_directory = cache_directory;
+      }
+      else if (auto const* const index_path{parser.value("--index"sv)}) {
+        options.index_path = index_path;
+      }
+      else if (auto const* const format{parser.value("--format"sv)}) {
+        if (format == "text"sv) {
+          options.format = line_format::text;
+        }
+        else if (format == "ndjson"sv) {
+          options.format = line_format::ndjson;
+        }
+        else if (format == "binary"sv) {
+          options.format = line_format::binary;
+        }
+        else {
+          fmt::print(stderr, "Unrecognized format, {}\n", quote_input(format));
+          return std::nullopt;
+        }
+      }
+      else if (auto const* const on_error{parser.value("--on-error"sv)}) {
+        if (on_error == "skip"sv) {
+          options.on_error = error_policy::skip;
+        }
+        else if (on_error == "stop"sv) {
+          options.on_error = error_policy::stop;
+        }
+        else if (on_error == "placeholder"sv) {
+          options.on_error = error_policy::placeholder;
+        }
+        else {
+          fmt::print(stderr, "Unrecognized error policy, {}\n", quote_input(on_error));
+          return std::nullopt;
+        }
+      }
+      else if (auto const* const field{parser.value("--field"sv)}) {
+        options.field = field;
+      }
+      else if (auto const* const csv_column{parser.value("--csv-column"sv)}) {
+        auto const argument{std::string_view{csv_column}};
+        auto [ptr, ec] = std::from_chars(argument.data(), argument.data() + argument.size(), options.csv_column);
+        if (ec != std::errc{} || ptr != argument.data() + argument.size()) {
+          fmt::print(stderr, "Unrecognized column number, {}\n", quote_input(argument));
+          return std::nullopt;
+        }
+        if (options.csv_column < 1) {
+          fmt::print(stderr, "Out-of-range column number, {}\n", options.csv_column);
+          return std::nullopt;
+        }
+        options.format = line_format::csv;
+      }
+      else if (parser.flag("--csv-header"sv)) {
+        options.csv_header = true;
+      }
+      else if (auto const* const num_threads{parser.value("--threads"sv)}) {
+        auto const argument{std::string_view{num_threads}};
+        auto [ptr, ec] = std::from_chars(argument.data(), argument.data() + argument.size(), options.num_threads);
+        auto const recognized{ptr == argument.data() + argument.size()
+                              && (ec == std::errc{} || ec == std::errc::result_out_of_range)};
+        if (!recognized) {
+          fmt::print(stderr, "Unrecognized thread count, {}\n", quote_input(argument));
+          return std::nullopt;
+        }
+        if (ec == std::errc::result_out_of_range || options.num_threads < 1 || options.num_threads > max_threads) {
+          fmt::print(stderr, "Out-of-range thread count, {} (1 to {})\n", quote_input(argument), max_threads);
+          return std::nullopt;
+        }
+        options.num_threads_given = true;
+      }
+      else if (auto const* const echo_limit{parser.value("--echo-limit"sv)}) {
+        auto const argument{std::string_view{echo_limit}};
+        auto [ptr, ec] = std::from_chars(argument.data(), argument.data() + argument.size(), options.echo_limit);
+        if (ec != std::errc{} || ptr != argument.data() + argument.size()) {
+          fmt::print(stderr, "Unrecognized byte count, {}\n", quote_input(argument));
+          return std::nullopt;
+        }
+      }
+      else if (auto const* const lookup{parser.value("--lookup"sv)}) {
+        auto const argument{std::string_view{lookup}};
+        std::uint64_t line_number;
+        auto [ptr, ec] = std::from_chars(argument.data(), argument.data() + argument.size(), line_number);
+        if (ec != std::errc{} || ptr != argument.data() + argument.size()) {
+          fmt::print(stderr, "Unrecognized line number, {}\n", quote_input(argument));
+          return std::nullopt;
+        }
+        options.lookup = line_number;
+      }
+      else if (parser.peek().starts_with("--"sv)) {
+        fmt::print(stderr, "Unrecognized option, {}\n", quote_input(parser.peek()));
+        return std::nullopt;
+      }
+      else if (options.input_path != nullptr) {
+        fmt::print(stderr, "Unexpected argument, {}\n", quote_input(parser.peek()));
+        return std::nullopt;
+      }
+      else if (auto* const input_path{parser.positional()}; std::string_view{input_path} != "-"sv) {
+        options.input_path = input_path;
+      }
+    }
+    if (parser.failed()) {
+      return std::nullopt;
+    }
+
+    if (options.csv_header && options.format != line_format::csv) {
+      fmt::print(stderr, "Option --csv-header requires --csv-column\n");
+      return std::nullopt;
+    }
+
+    if (options.rle_output && options.format != line_format::text) {
+      fmt::print(stderr, "Option --rle requires --format=text\n");
+      return std::nullopt;
+    }
+
+    if (options.trusted && options.format != line_format::binary) {
+      fmt::print(stderr, "Option --trusted requires --format=binary\n");
+      return std::nullopt;
+    }
+
+    if (options.format == line_format::binary && (options.histogram || options.index_path != nullptr)) {
+      fmt::print(stderr, "Option --format=binary cannot be combined with options --histogram or --index\n");
+      return std::nullopt;
+    }
+
+    if (options.histogram && (options.rle_output || options.index_path != nullptr || options.lookup)) {
+      fmt::print(stderr, "Option --histogram cannot be combined with options --rle, --index or --lookup\n");
+      return std::nullopt;
+    }
+
+    if (options.lookup && (options.index_path == nullptr || options.output_path == nullptr)) {
+      fmt::print(stderr, "Option --lookup requires options --index and --output\n");
+      return std::nullopt;
+    }
+
+    if (options.follow
+        && (options.format == line_format::binary || options.histogram || options.cache_directory != nullptr)) {
+      fmt::print(stderr, "Option --follow cannot be combined with options --format=binary, --histogram or --cache\n");
+      return std::nullopt;
+    }
+#if !defined(EG_HAVE_INOTIFY)
+    if (options.follow) {
+      fmt::print(stderr, "Option --follow is not supported on this platform\n");
+      return std::nullopt;
+    }
+#endif
+
+    if (options.shard_count != 0) {
+      if (options.input_path == nullptr) {
+        fmt::print(stderr, "Option --shard requires an input file\n");
+        return std::nullopt;
+      }
+      // The output of each shard is line for line, and no record may straddle two shards.
+      // Each shard would stop at its own first violation, rather than at the first of the whole input.
+      if (options.format == line_format::binary || options.format == line_format::csv || options.histogram
+          || options.index_path != nullptr || options.cache_directory != nullptr || options.follow
+          || options.checkpoint_path != nullptr || options.on_error == error_policy::stop) {
+        fmt::print(
+            stderr,
+            "Option --shard cannot be combined with options --format=binary, --csv-column, --histogram, --index, "
+            "--cache, --follow, --checkpoint or --on-error=stop\n");
+        return std::nullopt;
+      }
+    }
+
+    if (options.resume && options.checkpoint_path == nullptr) {
+      fmt::print(stderr, "Option --resume requires --checkpoint\n");
+      return std::nullopt;
+    }
+
+    if (options.checkpoint_path != nullptr) {
+      if (options.input_path == nullptr || options.output_path == nullptr) {
+        fmt::print(stderr, "Option --checkpoint requires an input file and --output\n");
+        return std::nullopt;
+      }
+      if (options.format == line_format::binary || options.histogram || options.index_path != nullptr
+          || options.cache_directory != nullptr) {
+        fmt::print(
+            stderr,
+            "Option --checkpoint cannot be combined with options --format=binary, --histogram, --index or --cache\n");
+        return std::nullopt;
+      }
+    }
+
+    if (options.cache_directory != nullptr && (options.input_path == nullptr || options.index_path != nullptr)) {
+      fmt::print(stderr, "Option --cache requires an input file and cannot be combined with option --index\n");
+      return std::nullopt;
+    }
+
+    return options;
+  }
+
+  /// @brief Writes runs of letters to the output, expanded or encoded.
+  /// @note When encoding, adjacent runs of the same letter are merged before they are written,
+  ///       so the expanded letters never need to be materialized and scanned.
+  class run_writer {
+  public:
+    run_writer(writer& output, bool encode)
+        : output_{output}
+        , encode_{encode}
+    {
+    }
+
+    void write(run r)
+    {
+      if (!encode_) {
+        output_.fill(r.letter, r.length);
+        return;
+      }
+
+      if (pending_.length != 0 && pending_.letter == r.letter) {
+        pending_.length += r.length;
+        return;
+      }
+
+      write_pending();
+      pending_ = r;
+    }
+
+    void end_line()
+    {
+      write_pending();
+      output_.push_back('\n');
+    }
+
+  private:
+    /// shorter runs are no shorter once encoded
+    static constexpr std::size_t min_encoded_length{4};
+
+    void write_pending()
+    {
+      if (pending_.length >= min_encoded_length) {
+        fmt::format_to(std::back_inserter(output_), "{}x{}", pending_.length, pending_.letter);
+      }
+      else {
+        output_.fill(pending_.letter, pending_.length);
+      }
+      pending_.length = 0;
+    }
+
+    writer& output_;
+    bool encode_;
+    run pending_{'\0', 0};
+  };
+
+  /// @return the contents of a field between a pair of double quotes, or the field itself if it is not quoted
+  auto strip_quotes(std::string_view field)
+  {
+    auto const quoted{field.size() >= 2 && field.front() == '"' && field.back() == '"'};
+    return quoted ? field.substr(1, field.size() - 2) : field;
+  }
+
+  void report_missing_field(std::uint64_t line_number, std::string_view field, writer& errors)
+  {
+    fmt::memory_buffer quoted;
+    quote_input(quoted, field);
+    fmt::format_to(
+        std::back_inserter(errors),
+        "{}:1: Missing field, {}\n",
+        line_number,
+        std::string_view{quoted.data(), quoted.size()});
+  }
+
+  void report_missing_column(std::uint64_t line_number, std::size_t column, writer& errors)
+  {
+    fmt::format_to(std::back_inserter(errors), "{}:1: Missing column, {}\n", line_number, column);
+  }
+
+  /// the most bytes in a line of input; a longer line is rejected, and only its first bytes are held in memory
+  constexpr std::size_t max_line_length{std::size_t{1} << 24U};
+
+  void report_long_line(std::uint64_t line_number, writer& errors)
+  {
+    fmt::format_to(
+        std::back_inserter(errors),
+        "{}:{}: Line too long (at most {} bytes)\n",
+        line_number,
+        max_line_length + 1,
+        max_line_length);
+  }
+
+  /// @return the size to which to grow a buffer that is full of one incomplete line
+  auto grown_size(std::size_t size)
+  {
+    return std::min(size * 2, max_line_length + 1);
+  }
+
+  /// @brief Sanitize and convert one line of input.
+  /// @param echo_limit the most bytes of a bad token to echo in its diagnostic
+  /// @param on_error what to do with a bad token; with `error_policy::stop`, the rest of the line is not converted
+  /// @return true iff every token on the line was accepted
+  auto convert_line(
+      std::string_view line,
+      std::uint64_t line_number,
+      run_writer& output,
+      writer& errors,
+      std::size_t echo_limit,
+      error_policy on_error)
+  {
+    constexpr auto whitespace{" \t\r"sv};
+
+    auto accepted{true};
+    for (auto first{line.find_first_not_of(whitespace)}; first != std::string_view::npos;) {
+      auto const last{std::min(line.find_first_of(whitespace, first), line.size())};
+      auto const token{line.substr(first, last - first)};
+      if (auto const result{sanitize_token(token)}; result.error == violation::none) {
+        output.write(result.letters);
+      }
+      else {
+        report(result, token, {line_number, first + 1}, errors, echo_limit);
+        accepted = false;
+        if (on_error == error_policy::stop) {
+          break;
+        }
+        if (on_error == error_policy::placeholder) {
+          output.write({placeholder_letter, 1});
+        }
+      }
+      first = line.find_first_not_of(whitespace, last);
+    }
+    output.end_line();
+
+    return accepted;
+  }
+
+  /// @brief Sanitize and convert one line of NDJSON input.
+  /// @param field the name of the member holding the token
+  /// @return true iff the token was accepted
+  /// @note Each record produces one record of output, e.g. `{"n":3,"letter":"C"}`,
+  ///       or, on error, e.g. `{"n":"1X","error":"unrecognized"}`.
+  auto convert_ndjson_record(
+      std::string_view line,
+      std::uint64_t line_number,
+      std::string_view field,
+      writer& output,
+      writer& errors,
+      std::size_t echo_limit)
+  {
+    // Blank lines carry no record; preserve them to keep lines aligned.
+    if (line.find_first_not_of(" \t\r"sv) == std::string_view::npos) {
+      output.push_back('\n');
+      return true;
+    }
+
+    output.push_back('{');
+    write_json_string(output, field);
+    output.push_back(':');
+
+    auto const value{find_member(line, field)};
+    if (!value) {
+      report_missing_field(line_number, field, errors);
+      output.write(R"(null,"error":"unrecognized"})"sv);
+      output.push_back('\n');
+      return false;
+    }
+
+    // The token may be quoted or bare.
+    auto const token{strip_quotes(*value)};
+    auto const column{std::size_t(token.data() - line.data()) + 1};
+
+    // Echo the token back as a number if it is one, else as a string.
+    auto const result{sanitize_token(token)};
+    auto const is_number{result.number_text.size() == token.size() && result.error != violation::unrecognized};
+    if (is_number && result.number) {
+      fmt::format_to(std::back_inserter(output), "{}", *result.number);
+    }
+    else if (is_number) {
+      // The digits of a number too big for `int` are still a valid JSON number.
+      output.write(result.number_text);
+    }
+    else {
+      // The token is untrusted, quoted or not, so it is escaped to keep the output valid JSON.
+      write_json_string(output, token);
+    }
+
+    if (result.error == violation::none) {
+      output.write(R"(,"letter":")"sv);
+      output.fill(result.letters.letter, result.letters.length);
+      output.write("\"}\n"sv);
+      return true;
+    }
+
+    report(result, token, {line_number, column}, errors, echo_limit);
+    output.write(R"(,"error":")"sv);
+    output.write(violation_name(result.error));
+    output.write("\"}\n"sv);
+    return false;
+  }
+
+  /// @brief Sanitize and convert one field of a CSV record, passing the other fields through.
+  /// @param column the number of the field holding the token, counting from 1
+  /// @return true iff the token was accepted
+  auto convert_csv_record(
+      std::string_view record,
+      std::uint64_t line_number,
+      std::size_t column,
+      writer& output,
+      writer& errors,
+      std::size_t echo_limit,
+      error_policy on_error)
+  {
+    // Keep the carriage return of a CRLF line ending out of the last field.
+    auto const carriage_return{record.ends_with('\r')};
+    if (carriage_return) {
+      record.remove_suffix(1);
+    }
+    auto const end_record = [&] {
+      if (carriage_return) {
+        output.push_back('\r');
+      }
+      output.push_back('\n');
+    };
+
+    // Blank lines carry no record; preserve them to keep lines aligned.
+    if (record.empty()) {
+      end_record();
+      return true;
+    }
+
+    auto const field{find_csv_field(record, column)};
+    if (!field) {
+      report_missing_column(line_number, column, errors);
+      output.write(record);
+      end_record();
+      return false;
+    }
+
+    // Pass through the fields either side of the token, converting only the token.
+    auto const field_begin{std::size_t(field->data() - record.data())};
+    auto const token{strip_quotes(*field)};
+    auto const result{sanitize_token(token)};
+    output.write(record.substr(0, field_begin));
+    if (result.error == violation::none) {
+      output.fill(result.letters.letter, result.letters.length);
+    }
+    else {
+      report(result, token, {line_number, std::size_t(token.data() - record.data()) + 1}, errors, echo_limit);
+      if (on_error == error_policy::placeholder) {
+        output.push_back(placeholder_letter);
+      }
+    }
+    output.write(record.substr(field_begin + field->size()));
+    end_record();
+
+    return result.error == violation::none;
+  }
+
+  /// @return the position of the newline ending the first line of `text`, or `npos` if it is incomplete
+  auto line_end(std::string_view text, line_format format)
+  {
+    return format == line_format::csv ? csv_record_end(text) : text.find('\n');
+  }
+
+  /// @brief Sanitize and convert one line of input in any of the line-based formats.
+  /// @return true iff the line was accepted
+  auto convert_record(
+      std::string_view line,
+      std::uint64_t line_number,
+      batch_options const& options,
+      run_writer& letters,
+      writer& output,
+      writer& errors)
+  {
+    if (line.size() > max_line_length) {
+      // Too long to convert or pass through, but it still produces a line of output to keep the lines aligned.
+      report_long_line(line_number, errors);
+      if (options.format == line_format::text) {
+        letters.end_line();
+        return false;
+      }
+      if (options.format == line_format::ndjson) {
+        output.push_back('{');
+        write_json_string(output, options.field);
+        output.write(R"(:null,"error":"unrecognized"})"sv);
+      }
+      output.push_back('\n');
+      return false;
+    }
+    switch (options.format) {
+      case line_format::text:
+        return convert_line(line, line_number, letters, errors, options.echo_limit, options.on_error);
+      case line_format::ndjson:
+        return convert_ndjson_record(line, line_number, options.field, output, errors, options.echo_limit);
+      case line_format::csv:
+        if (line_number == 1 && options.csv_header) {
+          output.write(line);
+          output.push_back('\n');
+          return true;
+        }
+        return convert_csv_record(
+            line, line_number, options.csv_column, output, errors, options.echo_limit, options.on_error);
+      case line_format::binary:
+        // Binary input has no lines; it is converted by `convert_binary_stream`.
+        eg_assert(false);
+        break;
+    }
+    return false;
+  }
+
+  /// @brief Sanitize and convert every line read from `input`.
+  /// @tparam Source `input_stream`, or `followed_file` when following
+  /// @param index if not null, records where the output of each line begins
+  /// @param start the progress of an earlier run which this one continues
+  template<typename Source>
+  auto convert_stream(
+      Source& input,
+      batch_options const& options,
+      writer& output,
+      writer& errors,
+      index_writer* index,
+      checkpoint const& start)
+  {
+    run_writer letters{output, options.rle_output};
+    std::vector<char> buffer(options.buffer_size);
+    std::size_t filled{0};
+    auto input_offset{start.input_offset};
+    auto next_checkpoint{start.input_offset + checkpoint_interval};
+    auto line_number{start.num_lines};
+    auto num_rejected_lines{start.num_rejected_lines};
+    // the rest of a line too long to hold is being discarded
+    auto skipping{false};
+
+    for (auto end_of_input{false}; !end_of_input;) {
+      auto const num_read{input.read({buffer.data() + filled, buffer.size() - filled})};
+      filled += num_read;
+      input_offset += num_read;
+      end_of_input = num_read == 0;
+      if (end_of_input && !input.error().empty()) {
+        fmt::format_to(std::back_inserter(errors), "Failed to read input: {}\n", input.error());
+        return outcome::input_error;
+      }
+
+      // Convert every complete line; keep the remainder for the next read.
+      auto text{std::string_view{buffer.data(), filled}};
+      if (skipping) {
+        auto const newline{text.find('\n')};
+        skipping = newline == std::string_view::npos;
+        text.remove_prefix(skipping ? text.size() : newline + 1);
+      }
+      auto stopped{false};
+      auto const convert = [&](std::string_view line) {
+        if (index != nullptr) {
+          index->start_line(output.offset(), errors.offset());
+        }
+        ++line_number;
+        if (!convert_record(line, line_number, options, letters, output, errors)) {
+          ++num_rejected_lines;
+          stopped = options.on_error == error_policy::stop;
+        }
+      };
+      for (auto newline{line_end(text, options.format)}; newline != std::string_view::npos && !stopped;
+           newline = line_end(text, options.format)) {
+        convert(text.substr(0, newline));
+        text.remove_prefix(newline + 1);
+      }
+      if (stopped) {
+        // Leave the rest of the input unread.
+        return outcome::input_error;
+      }
+      auto const partial_line{end_of_input && !text.empty()};
+      auto const long_line{text.size() == buffer.size() && text.size() > max_line_length};
+      if (partial_line || long_line) {
+        convert(text);
+        text.remove_prefix(text.size());
+        skipping = long_line;
+        if (stopped) {
+          return outcome::input_error;
+        }
+      }
+
+      if (options.follow && !(output.flush() && errors.flush())) {
+        // Followed lines are written as soon as they are converted; if that fails, stop waiting for more.
+        return outcome::input_error;
+      }
+
+      // A followed file's last line may yet be finished, so a checkpoint must not include it.
+      auto const converted{input_offset - text.size()};
+      if (options.checkpoint_path != nullptr && !(options.follow && partial_line) && !skipping
+          && (end_of_input || options.follow || converted >= next_checkpoint)) {
+        checkpoint const progress{
+            converted,
+            start.output_offset + output.offset(),
+            start.error_log_offset + errors.offset(),
+            line_number,
+            num_rejected_lines};
+        if (!output.flush() || !errors.flush()
+            || !write_checkpoint(options.checkpoint_path, progress, output.file(), errors.file())) {
+          fmt::format_to(std::back_inserter(errors), "Failed to write checkpoint: {}\n", std::strerror(errno));
+          return outcome::input_error;
+        }
+        next_checkpoint = converted + checkpoint_interval;
+      }
+
+      if (text.size() == buffer.size()) {
+        // A line longer than the buffer; make room for more of it.
+        buffer.resize(grown_size(buffer.size()));
+      }
+      else {
+        std::memmove(buffer.data(), text.data(), text.size());
+      }
+      filled = text.size();
+    }
+
+    return num_rejected_lines == 0 ? outcome::success : outcome::input_error;
+  }
+
+  /// @brief Sanitize one line of input, counting its letters and violations rather than converting it.
+  /// @param errors if not null, destination of diagnostics
+  /// @return true iff every token on the line was accepted
+  auto tally_line(
+      std::string_view line, std::uint64_t line_number, batch_options const& options, histogram& counts, writer* errors)
+  {
+    if (line.size() > max_line_length) {
+      counts.add(violation::unrecognized);
+      if (errors != nullptr) {
+        report_long_line(line_number, *errors);
+      }
+      return false;
+    }
+    auto const tally_token = [&](std::string_view token, std::size_t column) {
+      auto const result{sanitize_token(token)};
+      counts.add(result);
+      if (result.error != violation::none && errors != nullptr) {
+        report(result, token, {line_number, column}, *errors, options.echo_limit);
+      }
+      return result.error == violation::none;
+    };
+    auto const tally_missing = [&](auto report_missing, auto const& what) {
+      counts.add(violation::unrecognized);
+      if (errors != nullptr) {
+        report_missing(line_number, what, *errors);
+      }
+      return false;
+    };
+
+    switch (options.format) {
+      case line_format::text: {
+        constexpr auto whitespace{" \t\r"sv};
+
+        auto accepted{true};
+        for (auto first{line.find_first_not_of(whitespace)}; first != std::string_view::npos;) {
+          auto const last{std::min(line.find_first_of(whitespace, first), line.size())};
+          accepted &= tally_token(line.substr(first, last - first), first + 1);
+          first = line.find_first_not_of(whitespace, last);
+        }
+        return accepted;
+      }
+      case line_format::ndjson: {
+        if (line.find_first_not_of(" \t\r"sv) == std::string_view::npos) {
+          return true;
+        }
+        auto const value{find_member(line, options.field)};
+        if (!value) {
+          return tally_missing(report_missing_field, options.field);
+        }
+        auto const token{strip_quotes(*value)};
+        return tally_token(token, std::size_t(token.data() - line.data()) + 1);
+      }
+      case line_format::csv: {
+        if (line.ends_with('\r')) {
+          line.remove_suffix(1);
+        }
+        if (line.empty()) {
+          return true;
+        }
+        auto const field{find_csv_field(line, options.csv_column)};
+        if (!field) {
+          return tally_missing(report_missing_column, options.csv_column);
+        }
+        auto const token{strip_quotes(*field)};
+        return tally_token(token, std::size_t(token.data() - line.data()) + 1);
+      }
+      case line_format::binary:
+        // Binary input cannot be tallied.
+        eg_assert(false);
+        break;
+    }
+    return true;
+  }
+
+  /// @brief a part of the input, tallied by one thread
+  struct tally_chunk {
+    std::string_view text;
+
+    /// the first line of the chunk is a CSV header and should be skipped
+    bool header{false};
+
+    histogram counts;
+    std::uint64_t num_lines{0};
+
+    /// the first line holding a violation, numbered from the start of the chunk, and its offset in the chunk;
+    /// it and the lines after it are reported afterwards, once the numbers of the lines before the chunk are known
+    std::uint64_t first_rejected_line{0};
+    std::size_t first_rejected_offset{0};
+
+    /// the incomplete line at the end of the chunk, if any; only the last non-empty chunk can have one
+    std::string_view remainder;
+  };
+
+  /// @brief Tally every complete line of a chunk, and the incomplete line too if there is no more input.
+  /// @param index the position of the chunk in the buffer
+  /// @param first_stopped with `error_policy::stop`, the index of the first chunk known to hold a violation;
+  ///        shared by every thread, so that a chunk stops at its own first violation or as soon as an earlier one does
+  void tally(
+      tally_chunk& chunk,
+      std::size_t index,
+      batch_options const& options,
+      bool end_of_input,
+      std::atomic<std::size_t>& first_stopped)
+  {
+    chunk.counts = {};
+    chunk.num_lines = 0;
+    chunk.first_rejected_line = 0;
+
+    auto text{chunk.text};
+    auto const tally_one = [&](std::string_view line) {
+      ++chunk.num_lines;
+      if (chunk.header && chunk.num_lines == 1) {
+        return;
+      }
+      if (!tally_line(line, 0, options, chunk.counts, nullptr) && chunk.first_rejected_line == 0) {
+        chunk.first_rejected_line = chunk.num_lines;
+        chunk.first_rejected_offset = std::size_t(line.data() - chunk.text.data());
+        for (auto expected{first_stopped.load()};
+             options.on_error == error_policy::stop && index < expected
+             && !first_stopped.compare_exchange_weak(expected, index);) {
+        }
+      }
+    };
+    auto const stopped = [&] {
+      return options.on_error == error_policy::stop
+          && (chunk.first_rejected_line != 0 || first_stopped.load(std::memory_order_relaxed) < index);
+    };
+    for (auto newline{line_end(text, options.format)}; newline != std::string_view::npos && !stopped();
+         newline = line_end(text, options.format)) {
+      tally_one(text.substr(0, newline));
+      text.remove_prefix(newline + 1);
+    }
+    if (end_of_input && !text.empty() && !stopped()) {
+      tally_one(text);
+      text.remove_prefix(text.size());
+    }
+    chunk.remainder = text;
+  }
+
+  /// @brief threads which tally every chunk but the first, for as long as the input is being read
+  /// @note The threads are started once, rather than for each buffer of input, so that tallying does not
+  ///       allocate once it is under way.
+  class tally_workers {
+  public:
+    tally_workers(std::span<tally_chunk> chunks, batch_options const& options)
+        : chunks_{chunks}
+        , start_{std::ptrdiff_t(chunks.size())}
+        , finish_{std::ptrdiff_t(chunks.size())}
+    {
+      workers_.reserve(chunks.size() - 1);
+      for (std::size_t i{1}; i != chunks.size(); ++i) {
+        workers_.emplace_back([this, &options, i] {
+          for (start_.arrive_and_wait(); !stopped_; start_.arrive_and_wait()) {
+            tally(chunks_[i], i, options, end_of_input_, first_stopped_);
+            finish_.arrive_and_wait();
+          }
+        });
+      }
+    }
+
+    tally_workers(tally_workers const&) = delete;
+    tally_workers(tally_workers&&) = delete;
+    auto operator=(tally_workers const&) -> tally_workers& = delete;
+    auto operator=(tally_workers&&) -> tally_workers& = delete;
+
+    ~tally_workers()
+    {
+      stopped_ = true;
+      start_.arrive_and_wait();
+    }
+
+    /// @brief Tally every chunk, the first on this thread, and return once all are done.
+    void run(batch_options const& options, bool end_of_input)
+    {
+      end_of_input_ = end_of_input;
+      start_.arrive_and_wait();
+      tally(chunks_[0], 0, options, end_of_input, first_stopped_);
+      finish_.arrive_and_wait();
+    }
+
+  private:
+    std::span<tally_chunk> chunks_;
+
+    // Written before the threads are released by `start_`
+    bool end_of_input_{false};
+    bool stopped_{false};
+
+    // With --on-error=stop, the first chunk found to hold a violation; later chunks are abandoned
+    std::atomic<std::size_t> first_stopped_{SIZE_MAX};
+
+    std::barrier<> start_;
+    std::barrier<> finish_;
+
+    // Last, so that the threads are joined before the barriers are destroyed
+    std::vector<std::jthread> workers_;
+  };
+
+  /// @brief Sanitize every line read from `input` and write how often each letter and violation occurred.
+  /// @note The input is read in large pieces, each split between the threads at line boundaries.
+  ///       Every thread keeps its own counts, which are summed once the threads are done.
+  template<typename Source>
+  auto tally_stream(Source& input, batch_options const& options, writer& output, writer& errors)
+  {
+    // Only a sequential scan can tell which newlines end CSV records, so CSV is tallied on one thread.
+    auto const num_chunks{options.format == line_format::csv ? 1U : options.num_threads};
+    std::vector<tally_chunk> chunks(num_chunks);
+    tally_workers workers{chunks, options};
+    std::vector<char> buffer(options.chunk_size * num_chunks);
+    std::size_t filled{0};
+    std::uint64_t line_number{0};
+    histogram total;
+    auto accepted{true};
+    // the rest of a line too long to hold is being discarded
+    auto skipping{false};
+
+    for (auto end_of_input{false}; !end_of_input;) {
+      // Fill the buffer so that every thread has plenty to do.
+      while (filled != buffer.size() && !end_of_input) {
+        auto const num_read{input.read({buffer.data() + filled, buffer.size() - filled})};
+        filled += num_read;
+        end_of_input = num_read == 0;
+      }
+      if (!input.error().empty()) {
+        fmt::format_to(std::back_inserter(errors), "Failed to read input: {}\n", input.error());
+        return outcome::input_error;
+      }
+
+      auto text{std::string_view{buffer.data(), filled}};
+      if (skipping) {
+        auto const newline{text.find('\n')};
+        skipping = newline == std::string_view::npos;
+        text.remove_prefix(skipping ? text.size() : newline + 1);
+      }
+
+      // Split the buffer at the first newline after each equal share.
+      std::size_t begin{0};
+      for (std::size_t i{0}; i != num_chunks; ++i) {
+        auto const share{text.size() * (i + 1) / num_chunks};
+        auto const newline{i + 1 == num_chunks ? std::string_view::npos : text.find('\n', std::max(begin, share))};
+        auto const end{newline == std::string_view::npos ? text.size() : newline + 1};
+        chunks[i].text = text.substr(begin, end - begin);
+        chunks[i].header = i == 0 && line_number == 0 && options.csv_header;
+        chunks[i].remainder = {};
+        begin = end;
+      }
+
+      workers.run(options, end_of_input);
+
+      // Combine the results in order, reporting each violation with its line number.
+      auto remainder{text.substr(text.size())};
+      for (auto const& chunk : chunks) {
+        if (chunk.text.empty()) {
+          continue;
+        }
+        total += chunk.counts;
+        if (chunk.first_rejected_line != 0) {
+          // Rather than keep every rejected line, which would grow without bound, scan the chunk again.
+          accepted = false;
+          auto rest{chunk.text.substr(0, chunk.text.size() - chunk.remainder.size())};
+          rest.remove_prefix(chunk.first_rejected_offset);
+          histogram ignored;
+          for (auto chunk_line_number{chunk.first_rejected_line}; !rest.empty(); ++chunk_line_number) {
+            auto const newline{line_end(rest, options.format)};
+            auto const line{rest.substr(0, newline)};
+            tally_line(line, line_number + chunk_line_number, options, ignored, &errors);
+            if (options.on_error == error_policy::stop) {
+              // The counts cover only part of the input, so they are not written.
+              return outcome::input_error;
+            }
+            rest.remove_prefix(newline == std::string_view::npos ? rest.size() : newline + 1);
+          }
+        }
+        line_number += chunk.num_lines;
+        if (!chunk.remainder.empty()) {
+          remainder = chunk.remainder;
+        }
+      }
+
+      if (remainder.size() == buffer.size() && remainder.size() > max_line_length) {
+        // Too long to hold; reject what there is of it and discard the rest.
+        accepted = false;
+        ++line_number;
+        tally_line(remainder, line_number, options, total, &errors);
+        if (options.on_error == error_policy::stop) {
+          return outcome::input_error;
+        }
+        remainder.remove_prefix(remainder.size());
+        skipping = true;
+      }
+
+      // Keep the incomplete line for the next read.
+      if (remainder.size() == buffer.size()) {
+        // A line longer than the buffer; make room for more of it.
+        buffer.resize(grown_size(buffer.size()));
+      }
+      else {
+        std::memmove(buffer.data(), remainder.data(), remainder.size());
+      }
+      filled = remainder.size();
+    }
+
+    if (options.format == line_format::ndjson) {
+      write_histogram_ndjson(total, output);
+    }
+    else {
+      write_histogram(total, output);
+    }
+    return accepted ? outcome::success : outcome::input_error;
+  }
+
+  /// @brief A source of input bytes which are already in memory.
+  class span_source {
+  public:
+    explicit span_source(std::span<char const> bytes)
+        : bytes_{bytes}
+    {
+    }
+
+    auto read(std::span<char> destination) -> std::size_t
+    {
+      auto const size{std::min(destination.size(), bytes_.size())};
+      std::copy_n(bytes_.begin(), size, destination.begin());
+      bytes_ = bytes_.subspan(size);
+      return size;
+    }
+
+    /// @return an empty string, as reading memory does not fail
+    [[nodiscard]] auto error() const -> std::string const&
+    {
+      return error_;
+    }
+
+  private:
+    std::span<char const> bytes_;
+    std::string error_;
+  };
+
+  /// @return the number of newlines in `bytes`, counted on up to `num_threads` threads
+  auto count_lines(std::span<char const> bytes, unsigned num_threads)
+  {
+    constexpr std::size_t min_part_size{std::size_t{1} << 20U};
+    num_threads = unsigned(std::clamp(bytes.size() / min_part_size, std::size_t{1}, std::size_t{num_threads}));
+
+    std::vector<std::uint64_t> counts(num_threads);
+    {
+      std::vector<std::jthread> workers;
+      for (auto part{0U}; part != num_threads; ++part) {
+        workers.emplace_back([&, part] {
+          auto const begin{bytes.size() * part / num_threads};
+          auto const end{bytes.size() * (part + 1) / num_threads};
+          counts[part] = std::uint64_t(std::count(bytes.begin() + begin, bytes.begin() + end, '\n'));
+        });
+      }
+    }
+    return std::accumulate(counts.begin(), counts.end(), std::uint64_t{0});
+  }
+
+  /// @return the offset of the first line which begins at or after `part` `count`ths of the way through `bytes`
+  auto shard_boundary(std::span<char const> bytes, std::uint64_t part, std::uint64_t count) -> std::size_t
+  {
+    // Seek to the approximate boundary, then scan for the start of the next line.
+    auto const approximate{bytes.size() / count * part + bytes.size() % count * part / count};
+    if (approximate == 0) {
+      return 0;
+    }
+    auto const newline{std::find(bytes.begin() + std::ptrdiff_t(approximate) - 1, bytes.end(), '\n')};
+    return newline == bytes.end() ? bytes.size() : std::size_t(newline - bytes.begin()) + 1;
+  }
+
+  /// @brief Sanitize and convert the lines of one shard of the input, numbering them as in the whole input.
+  /// @note Concatenated in order, the output and diagnostics of every shard
+  ///       are those of a run over the whole input.
+  auto convert_shard(batch_options const& options, writer& output, writer& errors)
+  {
+    mapped_file const mapping{options.input_path};
+    if (!mapping.valid()) {
+      fmt::print(stderr, "Failed to read input file, {}: {}\n", quote_path(options.input_path), std::strerror(errno));
+      return outcome::usage_error;
+    }
+    auto const bytes{mapping.bytes()};
+    if (is_compressed(bytes)) {
+      fmt::print(stderr, "Option --shard requires uncompressed input\n");
+      return outcome::usage_error;
+    }
+
+    auto const begin{shard_boundary(bytes, options.shard_index - 1, options.shard_count)};
+    auto const end{shard_boundary(bytes, options.shard_index, options.shard_count)};
+    span_source source{bytes.subspan(begin, end - begin)};
+    checkpoint const start{begin, 0, 0, count_lines(bytes.first(begin), options.num_threads), 0};
+    return convert_stream(source, options, output, errors, nullptr, start);
+  }
+
+  /// @brief Convert the input to the output, writing diagnostics to the error log.
+  /// @param index the file to write a sparse line index to, or null
+  /// @param start the progress of an earlier run which this one continues
+  auto convert_files(
+      batch_options const& options,
+      std::FILE* input,
+      std::FILE* output,
+      std::FILE* error_log,
+      std::FILE* index,
+      checkpoint const& start)
+  {
+    // Where diagnostics are written while other threads are at work, i.e. histograms tallied on several threads
+    // and followed files, they are written by a thread of their own, so that a slow terminal or pipe on stderr
+    // does not hold up the others; elsewhere, the thread would cost more to start than it saves.
+    std::optional<log_queue> error_queue;
+    if (options.num_threads > 1 && (options.histogram || options.follow)) {
+      error_queue.emplace(error_log);
+    }
+    writer letters{output, options.buffer_size};
+    auto errors{error_queue ? writer{*error_queue} : writer{error_log}};
+    std::optional<index_writer> lines;
+    if (index != nullptr) {
+      lines.emplace(index);
+    }
+
+    auto const run = [&] {
+#if defined(EG_HAVE_INOTIFY)
+      if (options.follow) {
+        followed_file source{input, options.input_path};
+        return convert_stream(source, options, letters, errors, lines ? &*lines : nullptr, start);
+      }
+#endif
+      if (options.shard_count != 0) {
+        return convert_shard(options, letters, errors);
+      }
+      input_stream source{input, options.num_threads};
+      if (options.format == line_format::binary) {
+        return convert_binary_stream(source, options.trusted, options.on_error, letters, errors);
+      }
+      if (options.histogram) {
+        return tally_stream(source, options, letters, errors);
+      }
+      return convert_stream(source, options, letters, errors, lines ? &*lines : nullptr, start);
+    };
+    auto result{run()};
+
+    if (lines && !lines->finish(letters.offset(), errors.offset())) {
+      fmt::format_to(std::back_inserter(errors), "Failed to write index: {}\n", std::strerror(errno));
+      result = outcome::input_error;
+    }
+    if (!letters.flush()) {
+      fmt::format_to(std::back_inserter(errors), "Failed to write output: {}\n", std::strerror(errno));
+      result = outcome::input_error;
+    }
+    if (!errors.flush()) {
+      result = outcome::input_error;
+    }
+
+    return result;
+  }
+
+  /// the version of the project and a digest of the sources from which the program was built,
+  /// so that results stored by a program which might convert differently are never reused
+  constexpr auto build_id{std::string_view{EG_BUILD_ID}};
+
+  /// @brief Digest the settings which affect the results of a run, and the build of the program which produces them.
+  auto settings_digest(batch_options const& options) -> std::uint64_t
+  {
+    // The number of threads and --trusted do not change the results, so runs which differ only in them share entries.
+    auto const settings{fmt::format(
+        "build={} format={} field={} csv-column={} csv-header={} rle={} histogram={} echo-limit={} "
+        "on-error={}",
+        build_id,
+        int(options.format),
+        options.field,
+        options.csv_column,
+        options.csv_header,
+        options.rle_output,
+        options.histogram,
+        options.echo_limit,
+        int(options.on_error))};
+    return xxh64(settings);
+  }
+
+  /// @brief the name of a cache entry
+  auto cache_key(std::uint64_t content_digest, std::uint64_t settings_digest)
+  {
+    return fmt::format("{:016x}{:016x}", content_digest, settings_digest);
+  }
+
+  /// @brief report a failure to use the cache directory, described by errno
+  void report_cache_failure(std::string_view action, char const* directory)
+  {
+    fmt::print(stderr, "Failed to {} cache directory, {}: {}\n", action, quote_path(directory), std::strerror(errno));
+  }
+
+  /// @brief write diagnostics which were numbered from the first line of a chunk, renumbered for the whole input
+  /// @param line_offset the number of lines of input before the chunk
+  void write_rebased_diagnostics(std::string_view diagnostics, std::uint64_t line_offset, writer& errors)
+  {
+    while (!diagnostics.empty()) {
+      auto const size{std::min(diagnostics.find('\n'), diagnostics.size() - 1) + 1};
+      auto const diagnostic{diagnostics.substr(0, size)};
+      diagnostics.remove_prefix(size);
+
+      // Every diagnostic of a line begins with its line number.
+      std::uint64_t line_number;
+      auto [ptr, ec] = std::from_chars(diagnostic.data(), diagnostic.data() + diagnostic.size(), line_number);
+      if (ec != std::errc{}) {
+        errors.write(diagnostic);
+        continue;
+      }
+      fmt::format_to(std::back_inserter(errors), "{}", line_number + line_offset);
+      errors.write(diagnostic.substr(std::size_t(ptr - diagnostic.data())));
+    }
+  }
+
+  /// @brief Sanitize and convert every line of a chunk of input, numbering the lines from 1.
+  auto convert_chunk(std::string_view chunk, batch_options const& options, writer& output, writer& errors)
+  {
+    run_writer letters{output, options.rle_output};
+    auto accepted{true};
+    std::uint64_t line_number{0};
+    while (!chunk.empty()) {
+      auto const size{std::min(chunk.find('\n'), chunk.size())};
+      accepted &= convert_record(chunk.substr(0, size), ++line_number, options, letters, output, errors);
+      chunk.remove_prefix(std::min(size + 1, chunk.size()));
+    }
+    return accepted ? outcome::success : outcome::input_error;
+  }
+
+  /// @return true iff every line of the input can be converted independently of the lines before it
+  auto can_convert_in_chunks(batch_options const& options, std::span<char const> input)
+  {
+    // CSV records may span lines, histograms are not written line by line,
+    // and stopping at the first violation makes every line depend on the ones before it.
+    return (options.format == line_format::text || options.format == line_format::ndjson) && !options.histogram
+        && options.on_error != error_policy::stop && !is_compressed(input);
+  }
+
+  /// @brief Convert the input one content-defined chunk at a time, reusing the results of chunks seen before.
+  /// @note The results of each chunk are stored in the cache with their diagnostics numbered from the chunk's
+  ///       first line, so that they can be reused wherever the chunk appears in a later input.
+  /// @pre `can_convert_in_chunks(options, input)`
+  auto convert_chunks(
+      batch_options const& options,
+      std::string_view input,
+      std::uint64_t settings,
+      std::FILE* output,
+      std::FILE* error_log)
+  {
+    writer letters{output};
+    writer errors{error_log};
+    std::string stored_output;
+    std::string stored_errors;
+    std::uint64_t line_offset{0};
+    auto accepted{true};
+
+    while (!input.empty()) {
+      auto const chunk{input.substr(0, content_defined_chunk(input))};
+      input.remove_prefix(chunk.size());
+
+      cache_entry entry{options.cache_directory, cache_key(xxh64(chunk), settings)};
+      auto result{entry.find()};
+      if (!result) {
+        if (!entry.create()) {
+          report_cache_failure("write to", options.cache_directory);
+          return outcome::usage_error;
+        }
+        writer chunk_letters{entry.output()};
+        writer chunk_errors{entry.error_log()};
+        result = convert_chunk(chunk, options, chunk_letters, chunk_errors);
+        if (!chunk_letters.flush() || !chunk_errors.flush() || !entry.commit(*result)) {
+          report_cache_failure("write to", options.cache_directory);
+          return outcome::input_error;
+        }
+      }
+      if (!entry.read(stored_output, stored_errors)) {
+        report_cache_failure("read from", options.cache_directory);
+        return outcome::input_error;
+      }
+
+      letters.write(stored_output);
+      write_rebased_diagnostics(stored_errors, line_offset, errors);
+      line_offset += std::uint64_t(std::count(chunk.begin(), chunk.end(), '\n')) + (chunk.ends_with('\n') ? 0 : 1);
+      accepted &= *result == outcome::success;
+    }
+
+    auto result{accepted ? outcome::success : outcome::input_error};
+    if (!letters.flush()) {
+      fmt::format_to(std::back_inserter(errors), "Failed to write output: {}\n", std::strerror(errno));
+      result = outcome::input_error;
+    }
+    if (!errors.flush()) {
+      result = outcome::input_error;
+    }
+    return result;
+  }
+
+  /// @brief Serve the results of an identical earlier run from the cache, or convert and store them.
+  /// @note An identical rerun costs a hash of the input, on several threads, and a copy or reflink of the results.
+  ///       Otherwise, input which can be converted in chunks is converted by `convert_chunks`,
+  ///       so that when it differs from earlier inputs only in places,
+  ///       only the chunks of it which have not been seen before are converted.
+  auto cached_convert_files(batch_options const& options, std::FILE* input, std::FILE* output, std::FILE* error_log)
+  {
+    mapped_file const mapping{options.input_path};
+    if (!mapping.valid()) {
+      fmt::print(stderr, "Failed to read input file, {}: {}\n", quote_path(options.input_path), std::strerror(errno));
+      return outcome::usage_error;
+    }
+    auto const settings{settings_digest(options)};
+
+    cache_entry entry{options.cache_directory, cache_key(hash_bytes(mapping.bytes(), options.num_threads), settings)};
+    if (auto const cached{entry.find()}) {
+      if (!entry.deliver(output, error_log)) {
+        report_cache_failure("read from", options.cache_directory);
+        return outcome::input_error;
+      }
+      return *cached;
+    }
+
+    if (!entry.create()) {
+      report_cache_failure("write to", options.cache_directory);
+      return outcome::usage_error;
+    }
+
+    // The results are written to the cache and then copied to their destinations.
+    auto const bytes{std::string_view{mapping.bytes().data(), mapping.bytes().size()}};
+    auto const result{
+        can_convert_in_chunks(options, mapping.bytes())
+            ? convert_chunks(options, bytes, settings, entry.output(), entry.error_log())
+            : convert_files(options, input, entry.output(), entry.error_log(), nullptr, {})};
+    if (result == outcome::usage_error) {
+      return result;
+    }
+    auto const complete{std::ferror(entry.output()) == 0 && std::ferror(entry.error_log()) == 0};
+    if (!copy_file(entry.output(), output) || !copy_file(entry.error_log(), error_log)) {
+      fmt::print(stderr, "Failed to write output: {}\n", std::strerror(errno));
+      return outcome::input_error;
+    }
+    if (!complete || !entry.commit(result)) {
+      report_cache_failure("write to", options.cache_directory);
+      return outcome::input_error;
+    }
+
+    return result;
+  }
+
+  /// @brief Generate input with a realistic mix of tokens, and a few bad ones, for measuring speed.
+  auto synthetic_input(std::size_t size)
+  {
+    constexpr auto max_tokens_per_line{8U};
+    constexpr auto bad_token_rate{100U};
+
+    std::minstd_rand random{1};
+    std::string text;
+    text.reserve(size + max_tokens_per_line * 8);
+    while (text.size() < size) {
+      auto const num_tokens{random() % max_tokens_per_line};
+      for (auto token{0U}; token != num_tokens; ++token) {
+        auto const kind{random() % bad_token_rate};
+        auto const position{random() % 26 + 1};
+        if (kind == 0) {
+          fmt::format_to(std::back_inserter(text), "{}X ", position);
+        }
+        else if (kind < 10) {
+          fmt::format_to(std::back_inserter(text), "{}x{} ", random() % 9 + 2, position);
+        }
+        else {
+          fmt::format_to(std::back_inserter(text), "{} ", position);
+        }
+      }
+      text.push_back('\n');
+    }
+    return text;
+  }
+
+  /// @brief Measure the speed of batch mode with different parameters, and save the fastest to the tuning file.
+  /// @note The thread counts tried are limited by --threads.
+  ///       Each measurement is the best of several, to discount interruptions.
+  auto calibrate(batch_options const& options)
+  {
+    constexpr std::size_t sample_size{std::size_t{1} << 21U};
+    constexpr auto num_repetitions{3};
+    constexpr std::size_t min_threshold{std::size_t{1} << 16U};
+    constexpr auto threshold_growth{4U};
+
+    auto const path{options.tuning_path != nullptr ? std::string{options.tuning_path} : default_tuning_path()};
+    if (path.empty()) {
+      fmt::print(stderr, "Option --calibrate requires --tuning, as there is no cache directory\n");
+      return outcome::usage_error;
+    }
+    auto const sink{open_file("/dev/null", "wb", "output")};
+    if (!sink) {
+      return outcome::usage_error;
+    }
+
+    auto const sample{synthetic_input(sample_size)};
+    auto const measure = [&](batch_options const& trial, std::string_view input) {
+      auto fastest{std::chrono::steady_clock::duration::max()};
+      for (auto repetition{0}; repetition != num_repetitions; ++repetition) {
+        writer output{sink.get(), trial.buffer_size};
+        writer errors{sink.get()};
+        span_source source{input};
+        auto const start{std::chrono::steady_clock::now()};
+        if (trial.histogram) {
+          [[maybe_unused]] auto const result{tally_stream(source, trial, output, errors)};
+        }
+        else {
+          [[maybe_unused]] auto const result{convert_stream(source, trial, output, errors, nullptr, {})};
+        }
+        [[maybe_unused]] auto const flushed{output.flush() && errors.flush()};
+        fastest = std::min(fastest, std::chrono::steady_clock::now() - start);
+      }
+      return fastest;
+    };
+
+    // Each parameter in turn is set to the fastest of its candidates, keeping those already chosen.
+    auto trial{options};
+    auto const choose = [&](auto& parameter, auto const& candidates, std::string_view input) {
+      auto fastest{std::chrono::steady_clock::duration::max()};
+      auto choice{parameter};
+      for (auto const candidate : candidates) {
+        parameter = candidate;
+        if (auto const duration{measure(trial, input)}; duration < fastest) {
+          fastest = duration;
+          choice = candidate;
+        }
+      }
+      parameter = choice;
+    };
+
+    // Threads are used by the histogram, which divides the work between them.
+    trial.histogram = true;
+    std::vector<unsigned> thread_counts;
+    for (auto count{1U}; count < options.num_threads; count *= 2) {
+      thread_counts.push_back(count);
+    }
+    thread_counts.push_back(options.num_threads);
+    choose(trial.num_threads, thread_counts, sample);
+    choose(trial.chunk_size, std::array{std::size_t{1} << 18U, std::size_t{1} << 20U, std::size_t{1} << 22U}, sample);
+
+    // The smallest input which more than one thread works on faster than one.
+    trial.parallel_threshold = sample.size();
+    if (trial.num_threads > 1) {
+      auto parallel{trial};
+      auto serial{trial};
+      serial.num_threads = 1;
+      for (auto size{min_threshold}; size < sample.size(); size *= threshold_growth) {
+        auto const prefix{std::string_view{sample}.substr(0, size)};
+        if (measure(parallel, prefix) < measure(serial, prefix)) {
+          trial.parallel_threshold = size;
+          break;
+        }
+      }
+    }
+
+    // Buffers are used by conversion, which is done on one thread.
+    trial.histogram = false;
+    choose(
+        trial.buffer_size,
+        std::array{std::size_t{1} << 14U, std::size_t{1} << 16U, std::size_t{1} << 18U, std::size_t{1} << 20U},
+        sample);
+
+    tuning const result{trial.num_threads, trial.chunk_size, trial.buffer_size, trial.parallel_threshold};
+    if (!write_tuning(path.c_str(), result)) {
+      fmt::print(stderr, "Failed to write tuning file, {}: {}\n", quote_path(path), std::strerror(errno));
+      return outcome::usage_error;
+    }
+    return print_tuning(stdout, result) ? outcome::success : outcome::input_error;
+  }
+
+  /// @brief Use the tuning file given with --tuning, unless the user chose otherwise.
+  /// @return false iff the file exists but is not a sane tuning file
+  /// @note Without --tuning, the defaults are used, so that results and their speed do not depend on
+  ///       whether this machine was calibrated; a tuning file which does not exist yet is not an error.
+  auto apply_tuning(batch_options& options)
+  {
+    // The file written by --calibrate is used unless another is given, but as it was not asked for,
+    // a bad one is passed over with a warning rather than failing the run.
+    auto const given{options.tuning_path != nullptr};
+    auto const path{given ? std::string{options.tuning_path} : default_tuning_path()};
+    if (path.empty()) {
+      return true;
+    }
+    auto const parameters{read_tuning(path.c_str())};
+    if (!parameters) {
+      if (errno == ENOENT) {
+        return true;
+      }
+      auto const* const consequence{given ? "" : "; using the defaults"};
+      if (errno == EINVAL) {
+        fmt::print(stderr, "Invalid tuning file, {}{}\n", quote_path(path), consequence);
+      }
+      else {
+        fmt::print(
+            stderr, "Failed to read tuning file, {}: {}{}\n", quote_path(path), std::strerror(errno), consequence);
+      }
+      return !given;
+    }
+    if (!options.num_threads_given) {
+      options.num_threads = unsigned(std::min(parameters->num_threads, std::uint64_t{UINT_MAX}));
+    }
+    options.chunk_size = std::size_t(parameters->chunk_size);
+    options.buffer_size = std::size_t(parameters->buffer_size);
+    options.parallel_threshold = parameters->parallel_threshold;
+    return true;
+  }
+}
+
+auto unsanitized_batch_run(std::span<char*> args) -> outcome
+{
+  auto options{parse_options(args)};
+  if (!options) {
+    return outcome::usage_error;
+  }
+
+  if (options->calibrate) {
+    return calibrate(*options);
+  }
+  if (!apply_tuning(*options)) {
+    return outcome::usage_error;
+  }
+
+  if (options->lookup) {
+    return unsanitized_lookup(*options->lookup, options->index_path, options->output_path, options->error_log_path);
+  }
+
+  // Open the files named by the user, defaulting to the standard streams.
+  auto const open = [](char const* path, char const* mode, std::string_view role, unique_file& owner) {
+    if (path != nullptr) {
+      owner = open_file(path, mode, role);
+    }
+    return owner.get();
+  };
+  // A resumed run continues from the checkpoint, if an earlier run got as far as writing one.
+  std::optional<checkpoint> progress;
+  if (options->resume) {
+    auto failed{false};
+    progress = read_checkpoint(options->checkpoint_path, failed);
+    if (failed) {
+      return outcome::usage_error;
+    }
+  }
+  auto const* const write_mode{progress ? "r+b" : "wb"};
+
+  unique_file input_file;
+  unique_file output_file;
+  unique_file error_log_file;
+  unique_file index_file;
+  auto* const input{options->input_path != nullptr ? open(options->input_path, "rb", "input", input_file) : stdin};
+  auto* const output{
+      options->output_path != nullptr ? open(options->output_path, write_mode, "output", output_file) : stdout};
+  auto* const error_log{
+      options->error_log_path != nullptr ? open(options->error_log_path, write_mode, "error log", error_log_file)
+                                         : stderr};
+  auto* const index{open(options->index_path, "wb", "index", index_file)};
+  if (input == nullptr || output == nullptr || error_log == nullptr
+      || (options->index_path != nullptr && index == nullptr)) {
+    return outcome::usage_error;
+  }
+
+  // Small inputs take less time to convert on one thread than to share between several.
+  struct stat input_status {
+  };
+  if (!options->num_threads_given && ::fstat(::fileno(input), &input_status) == 0 && S_ISREG(input_status.st_mode)
+      && std::uint64_t(input_status.st_size) < options->parallel_threshold) {
+    options->num_threads = 1;
+  }
+
+  if (options->checkpoint_path != nullptr) {
+    // Offsets into decompressed input cannot be sought. The prefix is read without moving the input.
+    std::array<char, 4> prefix{};
+    auto const prefix_size{::pread(::fileno(input), prefix.data(), prefix.size(), 0)};
+    if (prefix_size > 0 && is_compressed({prefix.data(), std::size_t(prefix_size)})) {
+      fmt::print(stderr, "Option --checkpoint requires uncompressed input\n");
+      return outcome::usage_error;
+    }
+
+    // The error log can be rewound only if it is a file.
+    auto* const rewindable_error_log{options->error_log_path != nullptr ? error_log : nullptr};
+    if (!resume_files(progress.value_or(checkpoint{}), input, output, rewindable_error_log)) {
+      return outcome::usage_error;
+    }
+  }
+
+  if (options->cache_directory != nullptr) {
+    return cached_convert_files(*options, input, output, error_log);
+  }
+  return convert_files(*options, input, output, error_log, index, progress.value_or(checkpoint{}));
+}
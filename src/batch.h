@@ -0,0 +1,32 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Batch mode: converting a stream of positions rather than a single argument.
+
+#if !defined(EG_BATCH_H)
+#define EG_BATCH_H
+
+#include "outcome.h"
+
+#include <span>
+
+/// @brief Sanitize and convert every line of a file, or of stdin.
+/// @param args program arguments following `--batch`
+/// @note Each line of input holds whitespace-separated tokens
+///       and produces one line of output.
+///       A bad token is reported and skipped; it does not stop the run.
+/// @note There are no assumptions about the contents of the input.
+auto unsanitized_batch_run(std::span<char*> args) -> outcome;
+
+#endif  // EG_BATCH_H
@@ -0,0 +1,141 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Batch mode for binary input, in which each byte is a position.
+
+#include "binary.h"
+#include "letter.h"
+#include "token.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace {
+  constexpr std::size_t block_size{64};
+
+  /// @brief Sanitize and convert positions one at a time.
+  /// @param offset the index of the first position in the input
+  /// @return true iff every position was in range; with `error_policy::stop`, conversion ends at the first which is not
+  auto convert_checked(
+      std::span<unsigned char const> positions,
+      std::size_t offset,
+      error_policy on_error,
+      writer& output,
+      writer& errors)
+  {
+    auto accepted{true};
+    for (std::size_t i{0}; i != positions.size(); ++i) {
+      auto const position{int{positions[i]}};
+      if (position < min_number || position > max_number) {
+        report({violation::out_of_range, position, {}, {'\0', 0}}, {}, {1, offset + i + 1}, errors);
+        accepted = false;
+        if (on_error == error_policy::stop) {
+          break;
+        }
+        if (on_error == error_policy::placeholder) {
+          output.push_back(placeholder_letter);
+        }
+        continue;
+      }
+      output.push_back(number_to_letter(position));
+    }
+    return accepted;
+  }
+
+  /// @return true iff the smallest and largest positions of the block are both in range
+  /// @note The reduction has no branches, so compilers can vectorize it.
+  auto is_valid_block(std::span<unsigned char const> block)
+  {
+    unsigned char smallest{UCHAR_MAX};
+    unsigned char largest{0};
+    for (auto const position : block) {
+      smallest = std::min(smallest, position);
+      largest = std::max(largest, position);
+    }
+    return smallest >= min_number && largest <= max_number;
+  }
+
+  /// @brief Convert positions a block at a time, verifying each block before trusting it.
+  /// @param offset the index of the first position in the input
+  /// @return true iff every position was in range
+  auto convert_trusted(
+      std::span<unsigned char const> positions,
+      std::size_t offset,
+      error_policy on_error,
+      writer& output,
+      writer& errors)
+  {
+    auto accepted{true};
+    std::array<char, block_size> letters;
+    for (std::size_t block{0}; block < positions.size(); block += block_size) {
+      auto const size{std::min(block_size, positions.size() - block)};
+      auto const block_positions{positions.subspan(block, size)};
+      if (!is_valid_block(block_positions)) {
+        // The guarantee was broken; fall back to the checked path rather than assume.
+        accepted &= convert_checked(block_positions, offset + block, on_error, output, errors);
+        if (!accepted && on_error == error_policy::stop) {
+          break;
+        }
+        continue;
+      }
+
+      // Every position of the block is in range, but testing each again tells the compiler so:
+      // the assertions of `number_to_letter` drop out and the loop vectorizes.
+      for (std::size_t i{0}; i != size; ++i) {
+        auto const position{block_positions[i]};
+        letters[i] = position >= min_number && position <= max_number ? number_to_letter(position) : '\0';
+      }
+      output.write({letters.data(), size});
+    }
+    return accepted;
+  }
+}
+
+auto convert_binary_stream(input_stream& input, bool trusted, error_policy on_error, writer& output, writer& errors)
+    -> outcome
+{
+  constexpr std::size_t capacity{std::size_t{1} << 16U};
+
+  std::vector<char> buffer(capacity);
+  std::size_t offset{0};
+  auto accepted{true};
+  for (auto num_read{input.read(buffer)}; num_read != 0; num_read = input.read(buffer)) {
+    auto const positions{std::span{reinterpret_cast<unsigned char const*>(buffer.data()), num_read}};
+    accepted &= trusted ? convert_trusted(positions, offset, on_error, output, errors)
+                        : convert_checked(positions, offset, on_error, output, errors);
+    offset += num_read;
+    if (!accepted && on_error == error_policy::stop) {
+      break;
+    }
+  }
+  if (!input.error().empty()) {
+    fmt::format_to(std::back_inserter(errors), "Failed to read input: {}\n", input.error());
+    return outcome::input_error;
+  }
+
+  // The whole input is one line.
+  if (offset != 0) {
+    output.push_back('\n');
+  }
+
+  return accepted ? outcome::success : outcome::input_error;
+}
@@ -0,0 +1,36 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Batch mode for binary input, in which each byte is a position.
+
+#if !defined(EG_BINARY_H)
+#define EG_BINARY_H
+
+#include "input.h"
+#include "outcome.h"
+#include "token.h"
+#include "writer.h"
+
+/// @brief Sanitize and convert every byte read from `input`, writing the letters as a single line.
+/// @param trusted the producer of the input guarantees that every byte is a position in range;
+///        blocks of input are then verified with a cheap reduction rather than byte by byte
+/// @note Trusted input is still verified: a block which breaks the guarantee
+///       is converted by the checked path, with diagnostics, rather than assumed to be valid.
+///       Either way, the output is the same.
+/// @param on_error what to do with a byte which is out of range, once it is reported, as on column N of line 1
+/// @note With `error_policy::placeholder`, the output has one letter per byte of input.
+auto convert_binary_stream(input_stream& input, bool trusted, error_policy on_error, writer& output, writer& errors)
+    -> outcome;
+
+#endif  // EG_BINARY_H
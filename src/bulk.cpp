@@ -0,0 +1,231 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Converting many positions at once.
+/// @note The loops below are written so that compilers can vectorize them:
+///       each works through a fixed-size block without branching on the data,
+///       and only looks at the result once the block is done.
+
+#include "bulk.h"
+#include "eg_assert.h"
+#include "letter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace {
+  constexpr std::size_t block_size{64};
+
+  /// below this, starting a thread costs more than it saves
+  constexpr std::size_t min_partition_size{std::size_t{1} << 16U};
+
+  constexpr auto is_valid(int position)
+  {
+    // One unsigned comparison tests both ends of the range.
+    return unsigned(position - min_number) <= unsigned(max_number - min_number);
+  }
+
+  /// @return the letter at the position, or `'\0'` if the position is out of range
+  /// @note Testing the position here tells the compiler that the assertions of `number_to_letter` hold,
+  ///       so they drop out and loops which call this still vectorize.
+  constexpr auto letter_or_nul(int position)
+  {
+    return is_valid(position) ? number_to_letter(position) : '\0';
+  }
+}
+
+auto find_invalid_position(std::span<int const> positions) -> std::size_t
+{
+  for (std::size_t block{0}; block < positions.size(); block += block_size) {
+    auto const size{std::min(block_size, positions.size() - block)};
+    auto valid{true};
+    for (std::size_t i{0}; i != size; ++i) {
+      valid &= is_valid(positions[block + i]);
+    }
+    if (!valid) {
+      return block + std::size_t(std::find_if_not(&positions[block], &positions[block] + size, is_valid)
+                                 - &positions[block]);
+    }
+  }
+  return positions.size();
+}
+
+void positions_to_letters(std::span<int const> positions, std::span<char> letters)
+{
+  eg_assert(letters.size() == positions.size());
+
+  for (std::size_t block{0}; block < positions.size(); block += block_size) {
+    auto const size{std::min(block_size, positions.size() - block)};
+    auto valid{true};
+    for (std::size_t i{0}; i != size; ++i) {
+      valid &= is_valid(positions[block + i]);
+    }
+    eg_assert(valid);
+
+    for (std::size_t i{0}; i != size; ++i) {
+      letters[block + i] = letter_or_nul(positions[block + i]);
+    }
+  }
+}
+
+namespace {
+  /// @brief where the partitions of some work may begin: at `phase` plus a multiple of `granularity`
+  struct partition_grid {
+    std::size_t phase;
+    std::size_t granularity;
+  };
+
+  /// @return the grid on which partitions start at the beginning of a cache line of `output`
+  template<typename Element>
+  auto cache_line_grid(Element const* output) -> partition_grid
+  {
+    constexpr auto granularity{cache_line_size / sizeof(Element)};
+    auto const misalignment{reinterpret_cast<std::uintptr_t>(output) % cache_line_size / sizeof(Element)};
+    return {(granularity - misalignment) % granularity, granularity};
+  }
+
+  /// @brief Call `work(begin, end)` for each of several partitions of the range [0, size), each on its own thread.
+  /// @param grid where every partition after the first may begin
+  template<typename Work>
+  void for_each_partition(std::size_t size, partition_grid grid, unsigned num_threads, Work work)
+  {
+    eg_assert(num_threads != 0);
+
+    auto const num_partitions{std::max(std::min(std::size_t{num_threads}, size / min_partition_size), std::size_t{1})};
+    auto const boundary = [&](std::size_t partition) {
+      if (partition == num_partitions) {
+        return size;
+      }
+
+      // Round up to the grid.
+      auto const even{size * partition / num_partitions};
+      auto const steps{(even + grid.granularity - 1 - std::min(grid.phase, even)) / grid.granularity};
+      return std::min(grid.phase + steps * grid.granularity, size);
+    };
+
+    std::vector<std::jthread> workers;
+    workers.reserve(num_partitions - 1);
+    for (std::size_t partition{1}; partition != num_partitions; ++partition) {
+      workers.emplace_back(work, boundary(partition), boundary(partition + 1));
+    }
+    work(std::size_t{0}, boundary(1));
+  }
+}
+
+auto find_invalid_position(std::span<int const> positions, unsigned num_threads) -> std::size_t
+{
+  // The first invalid position found so far; partitions after it need not be finished.
+  std::atomic<std::size_t> first{positions.size()};
+  for_each_partition(positions.size(), cache_line_grid(positions.data()), num_threads, [&](std::size_t begin, std::size_t end) {
+    for (auto block{begin}; block < end && block < first.load(std::memory_order_relaxed); block += min_partition_size) {
+      auto const size{std::min(min_partition_size, end - block)};
+      auto const found{find_invalid_position(positions.subspan(block, size))};
+      if (found != size) {
+        auto const position{block + found};
+        for (auto expected{first.load()}; position < expected && !first.compare_exchange_weak(expected, position);) {
+        }
+        return;
+      }
+    }
+  });
+  return first;
+}
+
+void positions_to_letters(std::span<int const> positions, std::span<char> letters, unsigned num_threads)
+{
+  eg_assert(letters.size() == positions.size());
+
+  for_each_partition(letters.size(), cache_line_grid(letters.data()), num_threads, [&](std::size_t begin, std::size_t end) {
+    positions_to_letters(positions.subspan(begin, end - begin), letters.subspan(begin, end - begin));
+  });
+}
+
+auto letter_batch::num_failures() const -> std::size_t
+{
+  return std::transform_reduce(
+      failures_.begin(), failures_.end(), std::size_t{0}, std::plus{}, [](std::uint64_t word) {
+        return std::size_t(std::popcount(word));
+      });
+}
+
+auto letter_batch::failed(std::size_t index) const -> bool
+{
+  eg_assert(index < size());
+  return ((failures_[index / bits_per_word] >> (index % bits_per_word)) & 1U) != 0;
+}
+
+void letter_batch::resize(std::size_t size)
+{
+  letters_.resize(size);
+  errors_.resize(size);
+  failures_.resize((size + bits_per_word - 1) / bits_per_word);
+}
+
+void convert_positions(std::span<int const> positions, letter_batch& result, unsigned num_threads)
+{
+  static_assert(letter_batch::bits_per_word == block_size);
+
+  result.resize(positions.size());
+
+  // Start each partition on a cache line of every lane: the lanes are cache-aligned,
+  // so this is a multiple of the positions whose failures fill a cache line of the bitmap.
+  constexpr auto granularity{cache_line_size / sizeof(std::uint64_t) * letter_batch::bits_per_word};
+  for_each_partition(positions.size(), {0, granularity}, num_threads, [&](std::size_t begin, std::size_t end) {
+    for (auto block{begin}; block < end; block += block_size) {
+      auto const size{std::min(block_size, end - block)};
+      std::uint64_t failures{0};
+      for (std::size_t i{0}; i != size; ++i) {
+        auto const position{positions[block + i]};
+        auto const valid{is_valid(position)};
+        result.letters_[block + i] = letter_or_nul(position);
+        result.errors_[block + i] = valid ? violation::none : violation::out_of_range;
+        failures |= std::uint64_t{!valid} << i;
+      }
+      result.failures_[block / block_size] = failures;
+    }
+  });
+}
+
+void convert_text(std::string_view text, letter_batch& result)
+{
+  constexpr auto whitespace{" \t\r\n"};
+
+  result.letters_.clear();
+  result.errors_.clear();
+  result.failures_.clear();
+
+  for (auto first{text.find_first_not_of(whitespace)}; first != std::string_view::npos;) {
+    auto const last{std::min(text.find_first_of(whitespace, first), text.size())};
+    auto const token{sanitize_token(text.substr(first, last - first))};
+    if (token.error == violation::none) {
+      result.letters_.insert(result.letters_.end(), token.letters.length, token.letters.letter);
+      result.errors_.insert(result.errors_.end(), token.letters.length, violation::none);
+    }
+    else {
+      auto const index{result.letters_.size()};
+      result.letters_.push_back('\0');
+      result.errors_.push_back(token.error);
+      result.failures_.resize(index / letter_batch::bits_per_word + 1);
+      result.failures_.back() |= std::uint64_t{1} << (index % letter_batch::bits_per_word);
+    }
+    first = text.find_first_not_of(whitespace, last);
+  }
+
+  result.failures_.resize((result.letters_.size() + letter_batch::bits_per_word - 1) / letter_batch::bits_per_word);
+}
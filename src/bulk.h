@@ -0,0 +1,194 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Converting many positions at once.
+
+#if !defined(EG_BULK_H)
+#define EG_BULK_H
+
+#include "token.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <new>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// a common cache line size, used to keep the data written by different threads apart
+constexpr std::size_t cache_line_size{64};
+
+/// @brief An allocator of storage which starts at the beginning of a cache line.
+template<typename T>
+struct cache_aligned_allocator {
+  using value_type = T;
+
+  cache_aligned_allocator() = default;
+
+  template<typename U>
+  explicit cache_aligned_allocator(cache_aligned_allocator<U> const& /*other*/)
+  {
+  }
+
+  auto allocate(std::size_t n) -> T*
+  {
+    return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{cache_line_size}));
+  }
+
+  void deallocate(T* p, std::size_t /*n*/)
+  {
+    ::operator delete(p, std::align_val_t{cache_line_size});
+  }
+
+  friend auto operator==(cache_aligned_allocator const&, cache_aligned_allocator const&) -> bool = default;
+};
+
+/// @brief The results of sanitizing and converting many positions, as a structure of arrays.
+/// @note Each lane is a contiguous array which starts on a cache line.
+///       The letters can be handed to I/O as they are,
+///       and the failures can be counted or found with a popcount of the bitmap.
+class letter_batch {
+public:
+  /// the number of positions whose failures are recorded in each word of the bitmap
+  static constexpr std::size_t bits_per_word{64};
+
+  [[nodiscard]] auto size() const -> std::size_t
+  {
+    return letters_.size();
+  }
+
+  /// @return one letter per position, with '\0' in place of each failure
+  [[nodiscard]] auto letters() const -> std::span<char const>
+  {
+    return letters_;
+  }
+
+  /// @return one error code per position
+  [[nodiscard]] auto errors() const -> std::span<violation const>
+  {
+    return errors_;
+  }
+
+  /// @return one bit per position, set iff it failed; the first position is the least significant bit of the first word
+  [[nodiscard]] auto failures() const -> std::span<std::uint64_t const>
+  {
+    return failures_;
+  }
+
+  /// @return the number of positions which failed
+  [[nodiscard]] auto num_failures() const -> std::size_t;
+
+  /// @return true iff the position at `index` failed
+  /// @pre index is less than size()
+  [[nodiscard]] auto failed(std::size_t index) const -> bool;
+
+private:
+  friend void convert_positions(std::span<int const> positions, letter_batch& result, unsigned num_threads);
+  friend void convert_text(std::string_view text, letter_batch& result);
+
+  void resize(std::size_t size);
+
+  std::vector<char, cache_aligned_allocator<char>> letters_;
+  std::vector<violation, cache_aligned_allocator<violation>> errors_;
+  std::vector<std::uint64_t, cache_aligned_allocator<std::uint64_t>> failures_;
+};
+
+/// @brief Test many positions against the End User Contract at once.
+/// @return the index of the first position which is out of range, or `positions.size()` if there is none
+/// @note There are no assumptions about the values of the positions.
+auto find_invalid_position(std::span<int const> positions) -> std::size_t;
+
+/// @brief Convert many positions to letters at once.
+/// @param positions sanitized positions, e.g. those for which `find_invalid_position` found no fault
+/// @param letters destination of the letters
+/// @pre every position is in the range [1..26]
+/// @pre `letters` is the same size as `positions`
+void positions_to_letters(std::span<int const> positions, std::span<char> letters);
+
+/// @brief Test many positions against the End User Contract, dividing the work between threads.
+/// @param num_threads the most threads to use, including this one
+/// @pre num_threads is not zero
+/// @note Small spans are tested on this thread alone.
+auto find_invalid_position(std::span<int const> positions, unsigned num_threads) -> std::size_t;
+
+/// @brief Convert many positions to letters, dividing the work between threads.
+/// @param num_threads the most threads to use, including this one
+/// @pre num_threads is not zero
+/// @pre every position is in the range [1..26]
+/// @pre `letters` is the same size as `positions`
+/// @note Each thread writes a part of `letters` which starts on a cache line boundary,
+///       so no two threads write to the same cache line.
+void positions_to_letters(std::span<int const> positions, std::span<char> letters, unsigned num_threads);
+
+/// @brief Sanitize and convert many positions at once, dividing the work between threads.
+/// @param result replaced with the letter or the violation of each position; its storage is reused
+/// @param num_threads the most threads to use, including this one
+/// @pre num_threads is not zero
+/// @note There are no assumptions about the values of the positions.
+void convert_positions(std::span<int const> positions, letter_batch& result, unsigned num_threads = 1);
+
+/// @brief Sanitize and convert the positions written in text.
+/// @param text whitespace-separated tokens, following the syntax of batch mode, e.g. "8 5 3x12"
+/// @param result replaced with the letter or the violation of each position; its storage is reused
+/// @note A run yields one result per letter it denotes; an invalid token yields a single failure.
+void convert_text(std::string_view text, letter_batch& result);
+
+/// @return the number of threads which a bulk function should use under the given execution policy
+template<typename ExecutionPolicy>
+requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+auto bulk_num_threads(ExecutionPolicy&& /*policy*/) -> unsigned
+{
+  using policy = std::remove_cvref_t<ExecutionPolicy>;
+  if constexpr (
+      std::is_same_v<policy, std::execution::parallel_policy>
+      || std::is_same_v<policy, std::execution::parallel_unsequenced_policy>) {
+    return std::max(std::thread::hardware_concurrency(), 1U);
+  }
+  else {
+    // The single-threaded functions are already written to be vectorized.
+    return 1;
+  }
+}
+
+/// @brief Test many positions against the End User Contract, on several threads if `policy` allows.
+template<typename ExecutionPolicy>
+requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+auto find_invalid_position(ExecutionPolicy&& policy, std::span<int const> positions) -> std::size_t
+{
+  return find_invalid_position(positions, bulk_num_threads(policy));
+}
+
+/// @brief Convert many positions to letters, on several threads if `policy` allows.
+/// @pre every position is in the range [1..26]
+/// @pre `letters` is the same size as `positions`
+template<typename ExecutionPolicy>
+requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+void positions_to_letters(ExecutionPolicy&& policy, std::span<int const> positions, std::span<char> letters)
+{
+  positions_to_letters(positions, letters, bulk_num_threads(policy));
+}
+
+/// @brief Sanitize and convert many positions at once, on several threads if `policy` allows.
+template<typename ExecutionPolicy>
+requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>
+void convert_positions(ExecutionPolicy&& policy, std::span<int const> positions, letter_batch& result)
+{
+  convert_positions(positions, result, bulk_num_threads(policy));
+}
+
+#endif  // EG_BULK_H
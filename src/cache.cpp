@@ -0,0 +1,229 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Reusing the results of earlier batch runs whose input and settings were identical.
+
+#include "cache.h"
+
+#include <array>
+#include <cerrno>
+#include <span>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+namespace {
+  using namespace std::literals::string_view_literals;
+
+  /// how the outcome of a run is recorded in its entry
+  constexpr auto success_text{"success\n"sv};
+  constexpr auto input_error_text{"input_error\n"sv};
+
+  /// @brief Create a file with a unique name which is later renamed to `final_path`.
+  auto create_temporary(std::string const& final_path) -> std::pair<unique_file, std::string>
+  {
+    auto path{final_path + ".XXXXXX"};
+    auto const descriptor{::mkstemp(path.data())};
+    if (descriptor < 0) {
+      return {};
+    }
+    auto file{unique_file{::fdopen(descriptor, "w+b")}};
+    if (!file) {
+      ::close(descriptor);
+      ::unlink(path.c_str());
+      return {};
+    }
+    return {std::move(file), std::move(path)};
+  }
+
+  /// @brief copy the file at `path` to `destination`
+  auto copy_path(std::string const& path, std::FILE* destination)
+  {
+    auto const source{unique_file{std::fopen(path.c_str(), "rb")}};
+    return source && copy_file(source.get(), destination);
+  }
+}
+
+mapped_file::mapped_file(char const* path)
+    : descriptor_{::open(path, O_RDONLY | O_CLOEXEC)}
+{
+  struct stat status {
+  };
+  if (descriptor_ < 0 || ::fstat(descriptor_, &status) != 0) {
+    return;
+  }
+  size_ = std::size_t(status.st_size);
+  if (size_ == 0) {
+    // There is nothing to map, and mmap rejects an empty mapping.
+    valid_ = true;
+    return;
+  }
+  auto* const address{::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor_, 0)};
+  if (address == MAP_FAILED) {
+    return;
+  }
+  address_ = address;
+
+  // Start reading the whole file at once, as the threads which hash it each begin in a different place.
+  ::madvise(address_, size_, MADV_WILLNEED);
+  valid_ = true;
+}
+
+mapped_file::~mapped_file()
+{
+  if (address_ != nullptr) {
+    ::munmap(address_, size_);
+  }
+  if (descriptor_ >= 0) {
+    ::close(descriptor_);
+  }
+}
+
+auto copy_file(std::FILE* source, std::FILE* destination) -> bool
+{
+  if (std::fflush(destination) != 0 || std::fseek(source, 0, SEEK_SET) != 0) {
+    return false;
+  }
+
+#if defined(FICLONE)
+  struct stat status {
+  };
+  if (::fstat(::fileno(destination), &status) == 0 && S_ISREG(status.st_mode) && status.st_size == 0
+      && ::ioctl(::fileno(destination), FICLONE, ::fileno(source)) == 0) {
+    // The cloned contents are not seen through the destination's file position.
+    return ::lseek(::fileno(destination), 0, SEEK_END) >= 0;
+  }
+#endif
+
+  constexpr auto buffer_size{std::size_t{1} << 16U};
+  std::array<char, buffer_size> buffer;
+  for (std::size_t size; (size = std::fread(buffer.data(), 1, buffer.size(), source)) != 0;) {
+    if (std::fwrite(buffer.data(), 1, size, destination) != size) {
+      return false;
+    }
+  }
+  return std::ferror(source) == 0 && std::fflush(destination) == 0;
+}
+
+cache_entry::cache_entry(std::string_view directory, std::string_view key)
+    : directory_{directory}
+{
+  auto const stem{directory_ + '/' + std::string{key}};
+  output_path_ = stem + ".out";
+  error_log_path_ = stem + ".err";
+  outcome_path_ = stem + ".outcome";
+}
+
+auto cache_entry::find() const -> std::optional<outcome>
+{
+  auto const file{unique_file{std::fopen(outcome_path_.c_str(), "rb")}};
+  if (!file) {
+    return std::nullopt;
+  }
+
+  std::array<char, input_error_text.size() + 1> buffer{};
+  auto const text{std::string_view{buffer.data(), std::fread(buffer.data(), 1, buffer.size(), file.get())}};
+  if (text == success_text) {
+    return outcome::success;
+  }
+  if (text == input_error_text) {
+    return outcome::input_error;
+  }
+
+  // An entry which this program did not write is not trusted.
+  return std::nullopt;
+}
+
+auto cache_entry::deliver(std::FILE* output, std::FILE* error_log) const -> bool
+{
+  return copy_path(output_path_, output) && copy_path(error_log_path_, error_log);
+}
+
+auto cache_entry::read(std::string& output, std::string& error_log) const -> bool
+{
+  auto const read_path = [](std::string const& path, std::string& contents) {
+    auto const file{unique_file{std::fopen(path.c_str(), "rb")}};
+    if (!file) {
+      return false;
+    }
+    contents.clear();
+    constexpr auto buffer_size{std::size_t{1} << 16U};
+    std::array<char, buffer_size> buffer;
+    for (std::size_t size; (size = std::fread(buffer.data(), 1, buffer.size(), file.get())) != 0;) {
+      contents.append(buffer.data(), size);
+    }
+    return std::ferror(file.get()) == 0;
+  };
+  return read_path(output_path_, output) && read_path(error_log_path_, error_log);
+}
+
+auto cache_entry::create() -> bool
+{
+  if (::mkdir(directory_.c_str(), S_IRWXU | S_IRWXG | S_IRWXO) != 0 && errno != EEXIST) {
+    return false;
+  }
+
+  auto [output_file, output_path] = create_temporary(output_path_);
+  output_ = {std::move(output_file), std::move(output_path)};
+  if (!output_.file) {
+    return false;
+  }
+
+  auto [error_log_file, error_log_path] = create_temporary(error_log_path_);
+  error_log_ = {std::move(error_log_file), std::move(error_log_path)};
+  return bool{error_log_.file};
+}
+
+auto cache_entry::commit(outcome result) -> bool
+{
+  eg_assert(result != outcome::usage_error);
+
+  auto [outcome_file, outcome_path] = create_temporary(outcome_path_);
+  if (!outcome_file) {
+    return false;
+  }
+  auto const text{result == outcome::success ? success_text : input_error_text};
+  auto const written{
+      std::fwrite(text.data(), 1, text.size(), outcome_file.get()) == text.size()
+      && std::fclose(outcome_file.release()) == 0};
+
+  // The outcome is renamed into place last, marking the entry as complete.
+  if (!written || std::rename(output_.path.c_str(), output_path_.c_str()) != 0
+      || std::rename(error_log_.path.c_str(), error_log_path_.c_str()) != 0
+      || std::rename(outcome_path.c_str(), outcome_path_.c_str()) != 0) {
+    ::unlink(outcome_path.c_str());
+    return false;
+  }
+
+  output_.path.clear();
+  error_log_.path.clear();
+  return true;
+}
+
+cache_entry::~cache_entry()
+{
+  for (auto const* const temporary : {&output_, &error_log_}) {
+    if (!temporary->path.empty()) {
+      ::unlink(temporary->path.c_str());
+    }
+  }
+}
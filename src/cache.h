@@ -0,0 +1,134 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Reusing the results of earlier batch runs whose input and settings were identical.
+
+#if !defined(EG_CACHE_H)
+#define EG_CACHE_H
+
+#include "file.h"
+#include "outcome.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+/// @brief A read-only view of the contents of a file, mapped into memory.
+class mapped_file {
+public:
+  /// @param path null-terminated name of the file
+  explicit mapped_file(char const* path);
+
+  mapped_file(mapped_file const&) = delete;
+  mapped_file(mapped_file&&) = delete;
+  auto operator=(mapped_file const&) -> mapped_file& = delete;
+  auto operator=(mapped_file&&) -> mapped_file& = delete;
+
+  ~mapped_file();
+
+  /// @return true iff the file was mapped; otherwise errno describes the failure
+  [[nodiscard]] auto valid() const
+  {
+    return valid_;
+  }
+
+  [[nodiscard]] auto bytes() const -> std::span<char const>
+  {
+    return {static_cast<char const*>(address_), address_ != nullptr ? size_ : 0};
+  }
+
+private:
+  int descriptor_;
+  void* address_{nullptr};
+  std::size_t size_{0};
+  bool valid_{false};
+};
+
+/// @brief Copy the whole of one file to another.
+/// @param source a file open for reading
+/// @param destination a file open for writing, e.g. stdout
+/// @return true on success; otherwise errno describes the failure
+/// @note Where the destination is an empty regular file on the same file system,
+///       it is made a reflink of the source, sharing its blocks rather than copying them.
+auto copy_file(std::FILE* source, std::FILE* destination) -> bool;
+
+/// @brief The output, diagnostics and outcome of one batch run, stored in a cache directory.
+/// @note A new entry is written to temporary files which are renamed into place, the outcome last,
+///       so that a concurrent run never finds a partial entry.
+class cache_entry {
+public:
+  /// @param directory the cache directory, which is created if necessary
+  /// @param key identifies the input and settings of the run
+  cache_entry(std::string_view directory, std::string_view key);
+
+  /// @return the outcome of the run which stored this entry, or nothing if there is no such entry
+  [[nodiscard]] auto find() const -> std::optional<outcome>;
+
+  /// @brief copy the stored output and diagnostics to their destinations
+  /// @return true on success; otherwise errno describes the failure
+  /// @pre `find()` returned an outcome
+  [[nodiscard]] auto deliver(std::FILE* output, std::FILE* error_log) const -> bool;
+
+  /// @brief read the stored output and diagnostics into memory
+  /// @return true on success; otherwise errno describes the failure
+  /// @pre `find()` returned an outcome
+  [[nodiscard]] auto read(std::string& output, std::string& error_log) const -> bool;
+
+  /// @brief create the temporary files to which a new run writes its output and diagnostics
+  /// @return true on success; otherwise errno describes the failure
+  auto create() -> bool;
+
+  /// @pre `create()` succeeded
+  [[nodiscard]] auto output() const -> std::FILE*
+  {
+    return output_.file.get();
+  }
+
+  /// @pre `create()` succeeded
+  [[nodiscard]] auto error_log() const -> std::FILE*
+  {
+    return error_log_.file.get();
+  }
+
+  /// @brief rename the temporary files into place and record the outcome of the run
+  /// @return true on success; otherwise errno describes the failure
+  /// @pre `create()` succeeded and the temporary files have been flushed
+  auto commit(outcome result) -> bool;
+
+  cache_entry(cache_entry const&) = delete;
+  cache_entry(cache_entry&&) = delete;
+  auto operator=(cache_entry const&) -> cache_entry& = delete;
+  auto operator=(cache_entry&&) -> cache_entry& = delete;
+
+  /// @brief remove any temporary files which were not committed
+  ~cache_entry();
+
+private:
+  struct temporary {
+    unique_file file;
+    std::string path;
+  };
+
+  std::string directory_;
+  std::string output_path_;
+  std::string error_log_path_;
+  std::string outcome_path_;
+  temporary output_;
+  temporary error_log_;
+};
+
+#endif  // EG_CACHE_H
@@ -0,0 +1,122 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Recording the progress of a batch run so that a restarted run can continue from it.
+
+#include "checkpoint.h"
+#include "echo.h"
+#include "fields.h"
+#include "file.h"
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include <fmt/format.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  using namespace std::literals::string_view_literals;
+
+  /// @return the fields of a checkpoint, with their names
+  auto fields(checkpoint& progress)
+  {
+    return std::array{
+        field{"input-offset"sv, &progress.input_offset},
+        field{"output-offset"sv, &progress.output_offset},
+        field{"error-log-offset"sv, &progress.error_log_offset},
+        field{"lines"sv, &progress.num_lines},
+        field{"rejected-lines"sv, &progress.num_rejected_lines},
+    };
+  }
+
+  /// @brief write everything written to the file so far to storage
+  /// @return true on success, or if the file cannot be synchronized, e.g. because it is a terminal
+  auto sync(std::FILE* file)
+  {
+    return ::fdatasync(::fileno(file)) == 0 || errno == EINVAL || errno == EROFS;
+  }
+
+  /// @brief set the size of a file and move to its end
+  /// @return true iff the file was at least `size` bytes long and was cut to that size
+  auto truncate(std::FILE* file, std::uint64_t size)
+  {
+    struct stat status {
+    };
+    return ::fstat(::fileno(file), &status) == 0 && std::uint64_t(status.st_size) >= size
+        && ::ftruncate(::fileno(file), off_t(size)) == 0 && std::fseek(file, 0, SEEK_END) == 0;
+  }
+}
+
+auto read_checkpoint(char const* path, bool& failed) -> std::optional<checkpoint>
+{
+  eg_assert(path != nullptr);
+
+  auto const file{unique_file{std::fopen(path, "rb")}};
+  if (!file) {
+    if (errno == ENOENT) {
+      return std::nullopt;
+    }
+    fmt::print(stderr, "Failed to open checkpoint file, {}: {}\n", quote_path(path), std::strerror(errno));
+    failed = true;
+    return std::nullopt;
+  }
+
+  checkpoint progress;
+  if (!read_fields(file.get(), fields(progress))) {
+    fmt::print(stderr, "Corrupt checkpoint file, {}\n", quote_path(path));
+    failed = true;
+    return std::nullopt;
+  }
+
+  return progress;
+}
+
+auto write_checkpoint(char const* path, checkpoint const& progress, std::FILE* output, std::FILE* error_log) -> bool
+{
+  eg_assert(path != nullptr);
+
+  if (!sync(output) || !sync(error_log)) {
+    return false;
+  }
+
+  auto const temporary_path{std::string{path} + ".tmp"};
+  auto file{unique_file{std::fopen(temporary_path.c_str(), "wb")}};
+  if (!file) {
+    return false;
+  }
+  auto copy{progress};
+  auto const written{
+      write_fields(file.get(), fields(copy)) && std::fflush(file.get()) == 0 && sync(file.get())
+      && std::fclose(file.release()) == 0};
+  return written && std::rename(temporary_path.c_str(), path) == 0;
+}
+
+auto resume_files(checkpoint const& progress, std::FILE* input, std::FILE* output, std::FILE* error_log) -> bool
+{
+  if (std::fseek(input, long(progress.input_offset), SEEK_SET) != 0) {
+    fmt::print(stderr, "Failed to resume input: {}\n", std::strerror(errno));
+    return false;
+  }
+  if (!truncate(output, progress.output_offset)
+      || (error_log != nullptr && !truncate(error_log, progress.error_log_offset))) {
+    fmt::print(stderr, "Checkpoint does not match the output or error log\n");
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,69 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Recording the progress of a batch run so that a restarted run can continue from it.
+/// @note A checkpoint is a small text file holding one `name value` pair per line.
+
+#if !defined(EG_CHECKPOINT_H)
+#define EG_CHECKPOINT_H
+
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+
+/// @brief the number of bytes of input between periodic checkpoints
+constexpr std::uint64_t checkpoint_interval{std::uint64_t{1} << 26U};
+
+/// @brief how far a batch run had got
+/// @note Every byte of output and diagnostics before the offsets was flushed before the checkpoint was written,
+///       and nothing after them was produced by input before `input_offset`.
+struct checkpoint {
+  /// the number of bytes of input which were converted, which ends with a complete line
+  std::uint64_t input_offset{0};
+
+  /// the size of the output produced by that input
+  std::uint64_t output_offset{0};
+
+  /// the size of the error log produced by that input
+  std::uint64_t error_log_offset{0};
+
+  /// the number of lines of input which were converted
+  std::uint64_t num_lines{0};
+
+  /// the number of those lines which were not accepted
+  std::uint64_t num_rejected_lines{0};
+};
+
+/// @brief Read a checkpoint written by `write_checkpoint`.
+/// @param path null-terminated name of the checkpoint file
+/// @return the checkpoint, or nothing if there is no such file
+/// @note A file which exists but cannot be read, or is not a checkpoint, is an End User Contract violation
+///       and is diagnosed here; `failed` is then set.
+auto read_checkpoint(char const* path, bool& failed) -> std::optional<checkpoint>;
+
+/// @brief Make sure that the output and error log are stored, then replace the checkpoint file.
+/// @param path null-terminated name of the checkpoint file
+/// @param output, error_log the files to which the output and diagnostics were written, already flushed
+/// @return true on success; otherwise errno describes the failure
+/// @note The checkpoint is written to a temporary file which is renamed over the old one,
+///       so that a run which is stopped while writing it leaves the previous checkpoint intact.
+auto write_checkpoint(char const* path, checkpoint const& progress, std::FILE* output, std::FILE* error_log) -> bool;
+
+/// @brief Position the files of a run to continue from a checkpoint.
+/// @param error_log the error log, or null if diagnostics go to stderr and cannot be rewound
+/// @return true on success; otherwise the failure has been diagnosed
+/// @note Output and diagnostics produced after the checkpoint are discarded, as their input is converted again.
+auto resume_files(checkpoint const& progress, std::FILE* input, std::FILE* output, std::FILE* error_log) -> bool;
+
+#endif  // EG_CHECKPOINT_H
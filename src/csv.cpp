@@ -0,0 +1,63 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Just enough CSV to find one field of each record.
+
+#include "csv.h"
+#include "scan.h"
+
+// Both scans only visit quotes and separators, which are found a block at a time.
+// An escaped quote, `""`, toggles the quoted state twice and so needs no special handling.
+
+auto csv_record_end(std::string_view text) -> std::size_t
+{
+  byte_finder<'"', '\n'> finder{text};
+  auto quoted{false};
+  for (auto position{finder.next()}; position != std::string_view::npos; position = finder.next()) {
+    if (text[position] == '"') {
+      quoted = !quoted;
+    }
+    else if (!quoted) {
+      return position;
+    }
+  }
+  return std::string_view::npos;
+}
+
+auto find_csv_field(std::string_view record, std::size_t column) -> std::optional<std::string_view>
+{
+  byte_finder<'"', ','> finder{record};
+  auto quoted{false};
+  std::size_t field{1};
+  std::size_t begin{0};
+  for (auto position{finder.next()}; position != std::string_view::npos; position = finder.next()) {
+    if (record[position] == '"') {
+      quoted = !quoted;
+      continue;
+    }
+    if (quoted) {
+      continue;
+    }
+    if (field == column) {
+      return record.substr(begin, position - begin);
+    }
+    ++field;
+    begin = position + 1;
+  }
+
+  if (field == column) {
+    return record.substr(begin);
+  }
+  return std::nullopt;
+}
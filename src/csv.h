@@ -0,0 +1,34 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Just enough CSV to find one field of each record.
+
+#if !defined(EG_CSV_H)
+#define EG_CSV_H
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+/// @return the position of the newline which ends the first record of `text`, or `npos` if there is none
+/// @note Newlines between quotes are part of a field and do not end the record.
+auto csv_record_end(std::string_view text) -> std::size_t;
+
+/// @brief Find a field of a CSV record.
+/// @param record one record, without its terminating newline
+/// @param column the number of the field, counting from 1
+/// @return the text of the field, including any quotes, or nothing if the record has too few fields
+auto find_csv_field(std::string_view record, std::size_t column) -> std::optional<std::string_view>;
+
+#endif  // EG_CSV_H
@@ -0,0 +1,48 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Echoing untrusted input back to the user in diagnostics.
+
+#include "echo.h"
+#include "quote.h"
+
+namespace {
+  /// @brief adapts a `fmt::memory_buffer` to `append_quoted`
+  struct buffer_sink {
+    fmt::memory_buffer& buffer;
+
+    void push_back(char c)
+    {
+      buffer.push_back(c);
+    }
+
+    void append(std::string_view text)
+    {
+      buffer.append(text.data(), text.data() + text.size());
+    }
+  };
+}
+
+auto quote_input(std::string_view text, std::size_t limit) -> std::string
+{
+  fmt::memory_buffer quoted;
+  quote_input(quoted, text, limit);
+  return fmt::to_string(quoted);
+}
+
+void quote_input(fmt::memory_buffer& quoted, std::string_view text, std::size_t limit)
+{
+  buffer_sink sink{quoted};
+  append_quoted(sink, text, limit);
+}
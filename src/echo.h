@@ -0,0 +1,51 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Echoing untrusted input back to the user in diagnostics.
+
+#if !defined(EG_ECHO_H)
+#define EG_ECHO_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include <fmt/format.h>
+
+/// the number of bytes of offending input which a diagnostic echoes unless told otherwise
+constexpr std::size_t default_echo_limit{64};
+
+/// @brief Quote input so that it can be echoed in a diagnostic without harming the terminal or log it goes to.
+/// @param text the offending input, about which there are no assumptions
+/// @param limit the most bytes of `text` to echo
+/// @return `text` in single quotes, escaped, and followed by a note of its length if it was cut short,
+///         e.g. `'A\x1b[2J'` or `'AAAA'... (1048576 bytes)`
+/// @note Quotes, backslashes, control characters, bytes which are not valid UTF-8
+///       and Unicode characters which reorder text are escaped, e.g. `\'`, `\\`, `\n`, `\xff` or `\u202e`.
+///       Other text, including valid UTF-8, is echoed as it is.
+/// @note At most `limit` bytes of `text` are examined, so the cost does not grow with the input.
+auto quote_input(std::string_view text, std::size_t limit = default_echo_limit) -> std::string;
+
+/// @brief Append the quoted input to `quoted`, as `quote_input` would return it.
+/// @note With the default limit, the result fits in the inline storage of a `fmt::memory_buffer`,
+///       so a diagnostic can echo input without allocating.
+void quote_input(fmt::memory_buffer& quoted, std::string_view text, std::size_t limit = default_echo_limit);
+
+/// @brief Quote the name of a file given by the user, in full, so that it can be echoed in a diagnostic.
+inline auto quote_path(std::string_view path) -> std::string
+{
+  return quote_input(path, path.size());
+}
+
+#endif  // EG_ECHO_H
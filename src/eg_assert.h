@@ -0,0 +1,46 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file The assertion used to test C++ API contracts throughout the program.
+
+#if !defined(EG_ASSERT_H)
+#define EG_ASSERT_H
+
+#if defined(LOG_AND_CONTINUE_STRATEGY)
+#include <fmt/printf.h>
+#elif defined(TRAP_STRATEGY)
+#include <exception>
+#endif
+
+/// @brief A minimal assertion function for testing API contracts.
+/// @note This function lacks diagnostics and may not be suitable
+///       for defective or safety-critical applications.
+constexpr void eg_assert(bool condition)
+{
+  if (condition) {
+    return;
+  }
+
+#if defined(LOG_AND_CONTINUE_STRATEGY)
+  fmt::print(stderr, "a C++ API violation occurred\n");
+#elif defined(TRAP_STRATEGY)
+  std::terminate();
+#elif defined(PREVENTION_STRATEGY)
+  __builtin_unreachable();
+#else
+#error missing strategy pre-processor definition
+#endif
+}
+
+#endif  // EG_ASSERT_H
@@ -0,0 +1,57 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Small text files of `name value` lines, holding unsigned integers.
+
+#include "fields.h"
+
+#include <array>
+#include <charconv>
+
+#include <fmt/format.h>
+
+auto read_fields(std::FILE* file, std::span<field const> fields) -> bool
+{
+  constexpr std::size_t max_size{1024};
+  std::array<char, max_size> buffer{};
+  auto text{std::string_view{buffer.data(), std::fread(buffer.data(), 1, buffer.size(), file)}};
+  if (std::ferror(file) != 0 || text.size() == buffer.size()) {
+    return false;
+  }
+
+  for (auto const& [name, value] : fields) {
+    auto const line_size{text.find('\n')};
+    auto const line{text.substr(0, line_size)};
+    if (line_size == std::string_view::npos || line.size() <= name.size() + 1 || !line.starts_with(name)
+        || line[name.size()] != ' ') {
+      return false;
+    }
+    auto const* const first{line.data() + name.size() + 1};
+    auto const* const last{line.data() + line.size()};
+    if (auto const [ptr, ec] = std::from_chars(first, last, *value); ec != std::errc{} || ptr != last) {
+      return false;
+    }
+    text.remove_prefix(line_size + 1);
+  }
+
+  return text.empty();
+}
+
+auto write_fields(std::FILE* file, std::span<field const> fields) -> bool
+{
+  for (auto const& [name, value] : fields) {
+    fmt::print(file, "{} {}\n", name, *value);
+  }
+  return std::ferror(file) == 0;
+}
@@ -0,0 +1,43 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Small text files of `name value` lines, holding unsigned integers.
+
+#if !defined(EG_FIELDS_H)
+#define EG_FIELDS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string_view>
+
+/// @brief one line of a fields file
+struct field {
+  /// the name, which must not contain whitespace
+  std::string_view name;
+
+  /// the value, read or written
+  std::uint64_t* value;
+};
+
+/// @brief Read a file in which every field appears once, in order.
+/// @param file the file, open for reading
+/// @return true iff the file held exactly the given fields
+auto read_fields(std::FILE* file, std::span<field const> fields) -> bool;
+
+/// @brief Write the given fields to a file, one per line.
+/// @return true iff every write succeeded
+auto write_fields(std::FILE* file, std::span<field const> fields) -> bool;
+
+#endif  // EG_FIELDS_H
@@ -0,0 +1,57 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Ownership of files named by the user.
+
+#if !defined(EG_FILE_H)
+#define EG_FILE_H
+
+#include "echo.h"
+#include "eg_assert.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+#include <fmt/printf.h>
+
+struct file_closer {
+  void operator()(std::FILE* file) const
+  {
+    std::fclose(file);
+  }
+};
+
+using unique_file = std::unique_ptr<std::FILE, file_closer>;
+
+/// @brief Open a file named by the user.
+/// @param path null-terminated name of the file
+/// @param mode as passed to `std::fopen`
+/// @param role how the file is described in diagnostics, e.g. "input"
+/// @return the open file, or null if it could not be opened
+/// @note Failure is an End User Contract violation and is diagnosed here.
+inline auto open_file(char const* path, char const* mode, std::string_view role) -> unique_file
+{
+  eg_assert(path != nullptr);
+
+  auto file{unique_file{std::fopen(path, mode)}};
+  if (!file) {
+    fmt::print(stderr, "Failed to open {} file, {}: {}\n", role, quote_path(path), std::strerror(errno));
+  }
+  return file;
+}
+
+#endif  // EG_FILE_H
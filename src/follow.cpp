@@ -0,0 +1,183 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Reading a file which is still being written, like `tail -f`.
+
+#include "follow.h"
+
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  /// the signals which end the input
+  auto stop_signals()
+  {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    return signals;
+  }
+}
+
+followed_file::followed_file(std::FILE* file, char const* path)
+    : path_{path}
+    , descriptor_{::fileno(file)}
+{
+  auto const slash{path_.rfind('/')};
+  auto const directory{
+      slash == std::string::npos ? std::string{"."} : slash == 0 ? std::string{"/"} : path_.substr(0, slash)};
+
+  // Appends to the file and changes to the directory, such as rotation, wake the reader.
+  // Which one happened is not recorded; the file is examined afresh each time.
+  notifications_ = ::inotify_init1(IN_CLOEXEC);
+  if (notifications_ < 0
+      || ::inotify_add_watch(notifications_, directory.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
+             < 0) {
+    fail();
+    return;
+  }
+  file_watch_ = ::inotify_add_watch(notifications_, path_.c_str(), IN_MODIFY);
+
+  // Reading may begin part of the way through the file, e.g. when resuming.
+  auto const offset{::lseek(descriptor_, 0, SEEK_CUR)};
+  offset_ = offset > 0 ? std::uint64_t(offset) : 0;
+
+  // Signals end the input rather than the process.
+  auto const signals{stop_signals()};
+  if (::pthread_sigmask(SIG_BLOCK, &signals, &previous_signal_mask_) != 0) {
+    fail();
+    return;
+  }
+  signals_blocked_ = true;
+  signals_ = ::signalfd(-1, &signals, SFD_CLOEXEC);
+  if (signals_ < 0) {
+    fail();
+  }
+}
+
+followed_file::~followed_file()
+{
+  for (auto const descriptor : {owned_descriptor_, notifications_, signals_}) {
+    if (descriptor >= 0) {
+      ::close(descriptor);
+    }
+  }
+  if (signals_blocked_) {
+    ::pthread_sigmask(SIG_SETMASK, &previous_signal_mask_, nullptr);
+  }
+}
+
+auto followed_file::read(std::span<char> destination) -> std::size_t
+{
+  while (error_.empty()) {
+    auto const num_read{::read(descriptor_, destination.data(), destination.size())};
+    if (num_read > 0) {
+      offset_ += std::uint64_t(num_read);
+      return std::size_t(num_read);
+    }
+    if (num_read < 0) {
+      if (errno != EINTR) {
+        fail();
+      }
+      continue;
+    }
+
+    // At the end of the file; has it been truncated, or replaced by another of the same name?
+    struct stat current {
+    };
+    if (::fstat(descriptor_, &current) != 0) {
+      fail();
+      continue;
+    }
+    if (std::uint64_t(current.st_size) < offset_) {
+      if (::lseek(descriptor_, 0, SEEK_SET) != 0) {
+        fail();
+      }
+      offset_ = 0;
+      continue;
+    }
+    struct stat named {
+    };
+    auto const replaced{
+        ::stat(path_.c_str(), &named) != 0 || named.st_ino != current.st_ino || named.st_dev != current.st_dev};
+    if (replaced && reopen()) {
+      continue;
+    }
+
+    if (!wait()) {
+      break;
+    }
+  }
+  return 0;
+}
+
+auto followed_file::wait() -> bool
+{
+  std::array<pollfd, 2> descriptors{{{notifications_, POLLIN, 0}, {signals_, POLLIN, 0}}};
+  while (::poll(descriptors.data(), descriptors.size(), -1) < 0) {
+    if (errno != EINTR) {
+      fail();
+      return false;
+    }
+  }
+
+  if (descriptors[1].revents != 0) {
+    // Consume the signal so that it does not end the process once it is unblocked.
+    signalfd_siginfo signal{};
+    [[maybe_unused]] auto const num_read{::read(signals_, &signal, sizeof(signal))};
+    return false;
+  }
+
+  // Empty the queue of notifications; there is nothing in them which examining the file will not reveal.
+  alignas(inotify_event) std::array<char, 4096> events;
+  [[maybe_unused]] auto const num_read{::read(notifications_, events.data(), events.size())};
+  return true;
+}
+
+auto followed_file::reopen() -> bool
+{
+  auto const descriptor{::open(path_.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (descriptor < 0) {
+    // Not yet created; the directory watch will say when it is.
+    return false;
+  }
+
+  if (owned_descriptor_ >= 0) {
+    ::close(owned_descriptor_);
+  }
+  owned_descriptor_ = descriptor;
+  descriptor_ = descriptor;
+  offset_ = 0;
+
+  if (file_watch_ >= 0) {
+    ::inotify_rm_watch(notifications_, file_watch_);
+  }
+  file_watch_ = ::inotify_add_watch(notifications_, path_.c_str(), IN_MODIFY);
+  return true;
+}
+
+void followed_file::fail()
+{
+  error_ = std::strerror(errno);
+}
@@ -0,0 +1,80 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Reading a file which is still being written, like `tail -f`.
+
+#if !defined(EG_FOLLOW_H)
+#define EG_FOLLOW_H
+
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+
+/// @brief A source of the bytes appended to a file, which waits for more at the end of the file.
+/// @note The file and its directory are watched with inotify, so waiting costs nothing.
+///       If the file is renamed or deleted, e.g. by log rotation, the rest of it is read
+///       and then a new file of the same name is followed from its start.
+///       If the file is truncated, it is read again from its start.
+/// @note SIGINT and SIGTERM end the input, so that the lines read so far are finished cleanly.
+class followed_file {
+public:
+  /// @param file the file, which must outlive this object
+  /// @param path null-terminated name of the file, which is reopened after rotation
+  followed_file(std::FILE* file, char const* path);
+
+  followed_file(followed_file const&) = delete;
+  followed_file(followed_file&&) = delete;
+  auto operator=(followed_file const&) -> followed_file& = delete;
+  auto operator=(followed_file&&) -> followed_file& = delete;
+
+  ~followed_file();
+
+  /// @brief read up to `destination.size()` bytes, waiting for the file to grow if necessary
+  /// @return the number of bytes read, which is zero once a signal has ended the input or after an error
+  auto read(std::span<char> destination) -> std::size_t;
+
+  /// @return a description of the error which ended the input, or an empty string
+  [[nodiscard]] auto error() const -> std::string const&
+  {
+    return error_;
+  }
+
+private:
+  /// @brief wait for the file to change or for a signal
+  /// @return false if the input is over
+  auto wait() -> bool;
+
+  /// @brief follow the file now at `path_` after the previous one was rotated away
+  /// @return false if there is no file there yet
+  auto reopen() -> bool;
+
+  /// @brief end the input with the error described by errno
+  void fail();
+
+  std::string path_;
+  int descriptor_;
+  int owned_descriptor_{-1};
+  std::uint64_t offset_{0};
+  int notifications_{-1};
+  int file_watch_{-1};
+  int signals_{-1};
+  sigset_t previous_signal_mask_{};
+  bool signals_blocked_{false};
+  std::string error_;
+};
+
+#endif  // EG_FOLLOW_H
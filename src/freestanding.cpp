@@ -0,0 +1,326 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file A build of the program for single conversions which depends on neither the C library nor fmt.
+/// @note It is linked as a static position-independent executable with no dynamic loader
+///       and talks to Linux with raw system calls, so that as little as possible happens before and after `main`.
+/// @note It behaves as main.cpp does for a single conversion, except that batch mode and telemetry are missing.
+
+#include "letter.h"
+#include "outcome.h"
+#include "quote.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error The freestanding build supports only x86-64 Linux.
+#endif
+
+namespace {
+  using namespace std::literals::string_view_literals;
+
+  constexpr int stdout_fileno{1};
+  constexpr int stderr_fileno{2};
+
+  /// @brief Make a Linux system call with up to three arguments.
+  /// @return the result, or a negated `errno` value
+  auto system_call(long number, long first, long second, long third) -> long
+  {
+    long result;
+    asm volatile("syscall"
+                 : "=a"(result)
+                 : "a"(number), "D"(first), "S"(second), "d"(third)
+                 : "rcx", "r11", "memory");
+    return result;
+  }
+
+  [[noreturn]] void exit_group(int status)
+  {
+    constexpr long sys_exit_group{231};
+    for (;;) {
+      system_call(sys_exit_group, status, 0, 0);
+    }
+  }
+
+  /// @brief Text written with a single system call, in place of `fmt::print`.
+  class message {
+  public:
+    void push_back(char c)
+    {
+      if (size_ != text_.size()) {
+        text_[size_++] = c;
+      }
+    }
+
+    void append(std::string_view text)
+    {
+      for (auto const c : text) {
+        push_back(c);
+      }
+    }
+
+    void append(int value)
+    {
+      if (value < 0) {
+        push_back('-');
+      }
+      append_decimal(*this, value < 0 ? 0U - std::uint64_t(value) : std::uint64_t(value));
+    }
+
+    /// @brief Write the message to a file descriptor.
+    /// @note As with `fmt::print` to a `FILE` whose errors are not checked, a failure to write is not reported.
+    void print(int fd) const
+    {
+      constexpr long sys_write{1};
+      constexpr long eintr{-4};
+      for (std::size_t written{0}; written != size_;) {
+        auto const result{system_call(sys_write, fd, reinterpret_cast<long>(text_.data() + written), long(size_ - written))};
+        if (result == eintr) {
+          continue;
+        }
+        if (result <= 0) {
+          return;
+        }
+        written += std::size_t(result);
+      }
+    }
+
+  private:
+    // Enough for the longest diagnostic, which echoes at most `default_echo_limit` bytes, each escaped in four
+    std::array<char, 1024> text_;
+    std::size_t size_{0};
+  };
+
+  /// as `default_echo_limit` in echo.h, which cannot be included without the C++ library
+  constexpr std::size_t echo_limit{64};
+
+  /// @brief the outcome of parsing text as an `int`
+  struct parsed_int {
+    /// the number, unless it was invalid or out of range
+    int value{0};
+
+    /// the text was a number, but too big or small for `int`
+    bool out_of_range{false};
+
+    /// the number of characters parsed, which is zero if the text did not begin with a number
+    std::size_t size{0};
+  };
+
+  /// @brief Parse a decimal `int`, with an optional minus sign, from the start of `text`, as `std::from_chars` does.
+  constexpr auto parse_int(std::string_view text) -> parsed_int
+  {
+    auto const negative{text.starts_with('-')};
+    auto const first_digit{std::size_t{negative}};
+
+    // Accumulate the magnitude as a negative number, which has room for the magnitude of `INT_MIN`.
+    constexpr auto min_value{-2147483647 - 1};
+    auto value{0};
+    parsed_int result;
+    auto i{first_digit};
+    for (; i != text.size() && text[i] >= '0' && text[i] <= '9'; ++i) {
+      auto const digit{text[i] - '0'};
+      if (value < (min_value + digit) / 10) {
+        result.out_of_range = true;
+      }
+      else {
+        value = value * 10 - digit;
+      }
+    }
+    if (i == first_digit) {
+      return {};
+    }
+    result.size = i;
+    if (!result.out_of_range) {
+      if (!negative && value == min_value) {
+        result.out_of_range = true;
+      }
+      else {
+        result.value = negative ? value : -value;
+      }
+    }
+    return result;
+  }
+
+  /// @brief The single conversion of `unsanitized_run` in main.cpp.
+  auto unsanitized_run(std::span<char*> args) -> outcome
+  {
+    // Batch mode is missing.
+    if (!args.empty() && std::string_view{args[0]} == "--batch"sv) {
+      message error;
+      error.append("Option --batch is not supported by this build\n"sv);
+      error.print(stderr_fileno);
+      return outcome::usage_error;
+    }
+
+    // Verify correct number of arguments.
+    constexpr auto expected_num_params{1};
+    if (args.size() != expected_num_params) {
+      message error;
+      error.append("Wrong number of arguments provided. Expected="sv);
+      error.append(expected_num_params);
+      error.append("; Actual="sv);
+      append_decimal(error, args.size());
+      error.push_back('\n');
+      error.print(stderr_fileno);
+      return outcome::usage_error;
+    }
+
+    // Print help text if requested.
+    auto const argument{std::string_view{args[0]}};
+    if (argument == "--help"sv) {
+      message help;
+      help.append("This program prints the letter of the alphabet at the given position.\n"sv);
+      help.append("Usage: letter N\n"sv);
+      help.append("N: number between "sv);
+      help.append(min_number);
+      help.append(" and "sv);
+      help.append(max_number);
+      help.push_back('\n');
+      help.print(stdout_fileno);
+      return outcome::success;
+    }
+
+    // Telemetry is missing.
+    if (argument == "--telemetry-dump"sv) {
+      message error;
+      error.append("Option --telemetry-dump is not supported by this build\n"sv);
+      error.print(stderr_fileno);
+      return outcome::usage_error;
+    }
+
+    // Convert the argument to a number.
+    auto const parsed{parse_int(argument)};
+    if (parsed.size == 0 || parsed.size != argument.size()) {
+      message error;
+      error.append("Unrecognized number, "sv);
+      append_quoted(error, argument, echo_limit);
+      error.push_back('\n');
+      error.print(stderr_fileno);
+      return outcome::usage_error;
+    }
+
+    // Verify the range of number; a number too big for `int` is echoed as it was given.
+    if (parsed.out_of_range || parsed.value < min_number || parsed.value > max_number) {
+      message error;
+      error.append("Out-of-range number, "sv);
+      if (parsed.out_of_range) {
+        error.append(argument);
+      }
+      else {
+        error.append(parsed.value);
+      }
+      error.push_back('\n');
+      error.print(stderr_fileno);
+      return outcome::usage_error;
+    }
+
+    message letter;
+    letter.push_back(number_to_letter(parsed.value));
+    letter.print(stdout_fileno);
+    return outcome::success;
+  }
+}
+
+/// @brief Run the program, given the stack as the kernel left it: `argc`, then `argv`.
+extern "C" [[noreturn]] void freestanding_start(long* stack)
+{
+  auto const argc{std::size_t(stack[0])};
+  auto** const argv{reinterpret_cast<char**>(stack + 1)};
+
+  switch (unsanitized_run(std::span{argv + 1, argc - 1U})) {
+    case outcome::success:
+      exit_group(0);
+    case outcome::usage_error: {
+      message hint;
+      hint.append("Try --help\n"sv);
+      hint.print(stdout_fileno);
+      exit_group(1);
+    }
+    case outcome::input_error:
+      exit_group(1);
+  }
+  exit_group(1);
+}
+
+// The entry point: pass the stack to `freestanding_start`, with the stack aligned as a call requires.
+asm(R"(
+  .text
+  .globl _start
+  .type _start, @function
+_start:
+  xor %ebp, %ebp
+  mov %rsp, %rdi
+  and $-16, %rsp
+  call freestanding_start
+  hlt
+)");
+
+// The C library functions which the compiler and the C++ library headers may call
+extern "C" {
+auto memcmp(void const* lhs, void const* rhs, std::size_t count) -> int
+{
+  auto const* l{static_cast<unsigned char const*>(lhs)};
+  auto const* r{static_cast<unsigned char const*>(rhs)};
+  for (std::size_t i{0}; i != count; ++i) {
+    if (l[i] != r[i]) {
+      return l[i] < r[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+auto memcpy(void* destination, void const* source, std::size_t count) -> void*
+{
+  auto* d{static_cast<unsigned char*>(destination)};
+  auto const* s{static_cast<unsigned char const*>(source)};
+  for (std::size_t i{0}; i != count; ++i) {
+    d[i] = s[i];
+  }
+  return destination;
+}
+
+auto memset(void* destination, int value, std::size_t count) -> void*
+{
+  auto* d{static_cast<unsigned char*>(destination)};
+  for (std::size_t i{0}; i != count; ++i) {
+    d[i] = static_cast<unsigned char>(value);
+  }
+  return destination;
+}
+
+auto strlen(char const* text) -> std::size_t
+{
+  std::size_t size{0};
+  while (text[size] != '\0') {
+    ++size;
+  }
+  return size;
+}
+}
+
+// With no C++ runtime, a broken C++ API contract ends the program as abruptly as `std::terminate` would.
+[[noreturn]] void std::terminate() noexcept
+{
+  __builtin_trap();
+}
+
+// ...which is also how the C++ library headers report an out-of-range index, as they cannot throw.
+[[noreturn]] void std::__throw_out_of_range_fmt(char const* /*format*/, ...)
+{
+  __builtin_trap();
+}
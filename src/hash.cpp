@@ -0,0 +1,191 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file A fast, non-cryptographic hash for recognizing input which has been seen before.
+
+#include "hash.h"
+#include "eg_assert.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+  constexpr std::uint64_t prime1{0x9e3779b185ebca87U};
+  constexpr std::uint64_t prime2{0xc2b2ae3d27d4eb4fU};
+  constexpr std::uint64_t prime3{0x165667b19e3779f9U};
+  constexpr std::uint64_t prime4{0x85ebca77c2b2ae63U};
+  constexpr std::uint64_t prime5{0x27d4eb2f165667c5U};
+
+  /// the bytes consumed by each step of the main loop
+  constexpr std::size_t stripe_size{32};
+
+  /// the bytes hashed independently before their digests are combined
+  constexpr std::size_t chunk_size{std::size_t{1} << 20U};
+
+  /// content-defined chunks are no smaller than this, unless they end the text
+  constexpr std::size_t min_chunk_size{std::size_t{1} << 14U};
+
+  /// beyond this, a chunk ends at the next newline regardless of its content
+  constexpr std::size_t max_chunk_size{std::size_t{1} << 18U};
+
+  /// a boundary falls where these bits of the rolling hash are zero, i.e. one in 64Ki bytes after the minimum
+  constexpr std::uint64_t boundary_mask{std::uint64_t{0xffff} << 48U};
+
+  /// a random value for each byte, added to the rolling hash as the byte goes by
+  constexpr auto gear_table{[] {
+    // splitmix64
+    std::array<std::uint64_t, 256> table{};
+    std::uint64_t state{0};
+    for (auto& entry : table) {
+      state += prime1;
+      auto z{state};
+      z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9U;
+      z = (z ^ (z >> 27U)) * 0x94d049bb133111ebU;
+      entry = z ^ (z >> 31U);
+    }
+    return table;
+  }()};
+
+  template<typename Word>
+  auto load(char const* bytes)
+  {
+    static_assert(std::endian::native == std::endian::little, "byte order of digests would differ");
+    Word word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+  }
+
+  constexpr auto round(std::uint64_t accumulator, std::uint64_t input)
+  {
+    constexpr auto rotation{31};
+    return std::rotl(accumulator + input * prime2, rotation) * prime1;
+  }
+
+  constexpr auto merge_round(std::uint64_t accumulator, std::uint64_t lane)
+  {
+    return (accumulator ^ round(0, lane)) * prime1 + prime4;
+  }
+
+  constexpr auto avalanche(std::uint64_t h)
+  {
+    constexpr auto shift1{33};
+    constexpr auto shift2{29};
+    constexpr auto shift3{32};
+    h ^= h >> shift1;
+    h *= prime2;
+    h ^= h >> shift2;
+    h *= prime3;
+    h ^= h >> shift3;
+    return h;
+  }
+}
+
+auto xxh64(std::span<char const> bytes, std::uint64_t seed) -> std::uint64_t
+{
+  auto const* p{bytes.data()};
+  auto const* const end{bytes.data() + bytes.size()};
+
+  std::uint64_t h;
+  if (bytes.size() >= stripe_size) {
+    // Four independent lanes, so that the processor can work on them at once.
+    std::uint64_t v1{seed + prime1 + prime2};
+    std::uint64_t v2{seed + prime2};
+    std::uint64_t v3{seed};
+    std::uint64_t v4{seed - prime1};
+    for (; end - p >= std::ptrdiff_t{stripe_size}; p += stripe_size) {
+      v1 = round(v1, load<std::uint64_t>(p));
+      v2 = round(v2, load<std::uint64_t>(p + 8));
+      v3 = round(v3, load<std::uint64_t>(p + 16));
+      v4 = round(v4, load<std::uint64_t>(p + 24));
+    }
+    h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+    h = merge_round(h, v1);
+    h = merge_round(h, v2);
+    h = merge_round(h, v3);
+    h = merge_round(h, v4);
+  }
+  else {
+    h = seed + prime5;
+  }
+
+  h += bytes.size();
+
+  // The remaining bytes, a word at a time.
+  for (; end - p >= 8; p += 8) {
+    h ^= round(0, load<std::uint64_t>(p));
+    h = std::rotl(h, 27) * prime1 + prime4;
+  }
+  if (end - p >= 4) {
+    h ^= load<std::uint32_t>(p) * prime1;
+    h = std::rotl(h, 23) * prime2 + prime3;
+    p += 4;
+  }
+  for (; p != end; ++p) {
+    h ^= static_cast<unsigned char>(*p) * prime5;
+    h = std::rotl(h, 11) * prime1;
+  }
+
+  return avalanche(h);
+}
+
+auto hash_bytes(std::span<char const> bytes, unsigned num_threads) -> std::uint64_t
+{
+  eg_assert(num_threads != 0);
+
+  auto const num_chunks{(bytes.size() + chunk_size - 1) / chunk_size};
+  std::vector<std::uint64_t> digests(num_chunks);
+  auto const hash_chunks = [&](std::size_t first) {
+    for (auto chunk{first}; chunk < num_chunks; chunk += num_threads) {
+      auto const offset{chunk * chunk_size};
+      digests[chunk] = xxh64(bytes.subspan(offset, std::min(chunk_size, bytes.size() - offset)));
+    }
+  };
+  {
+    std::vector<std::jthread> workers;
+    for (std::size_t worker{1}; worker < num_threads && worker < num_chunks; ++worker) {
+      workers.emplace_back(hash_chunks, worker);
+    }
+    hash_chunks(0);
+  }
+
+  return xxh64({reinterpret_cast<char const*>(digests.data()), digests.size() * sizeof(std::uint64_t)}, bytes.size());
+}
+
+auto content_defined_chunk(std::string_view text) -> std::size_t
+{
+  if (text.size() <= min_chunk_size) {
+    return text.size();
+  }
+
+  // A gear hash: each byte shifts out of the high bits after 64 more bytes, so the high bits depend on them all.
+  auto const limit{std::min(text.size(), max_chunk_size)};
+  auto boundary{limit};
+  std::uint64_t h{0};
+  for (auto i{min_chunk_size}; i != limit; ++i) {
+    h = (h << 1U) + gear_table[static_cast<unsigned char>(text[i])];
+    if ((h & boundary_mask) == 0) {
+      boundary = i + 1;
+      break;
+    }
+  }
+
+  // Lines are not split, so that each chunk can be converted alone.
+  auto const newline{text.find('\n', boundary - 1)};
+  return newline == std::string_view::npos ? text.size() : newline + 1;
+}
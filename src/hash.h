@@ -0,0 +1,44 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file A fast, non-cryptographic hash for recognizing input which has been seen before.
+
+#if !defined(EG_HASH_H)
+#define EG_HASH_H
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+/// @brief Hash some bytes with the XXH64 algorithm.
+/// @param seed varies the hash, e.g. to separate different uses of it
+auto xxh64(std::span<char const> bytes, std::uint64_t seed = 0) -> std::uint64_t;
+
+/// @brief Hash a large number of bytes, dividing the work between threads.
+/// @param num_threads the most threads to use, including this one
+/// @pre num_threads is not zero
+/// @note The bytes are divided into chunks which are hashed independently, and their digests are hashed in turn,
+///       so the result does not depend on the number of threads.
+auto hash_bytes(std::span<char const> bytes, unsigned num_threads) -> std::uint64_t;
+
+/// @brief Find where the first content-defined chunk of some text ends.
+/// @return the size of the chunk, which ends with a newline unless it runs to the end of the text
+/// @note Boundaries are placed where a rolling hash of the preceding bytes matches a pattern,
+///       so an edit moves only the boundaries near it,
+///       and the unchanged text either side divides into the same chunks as before.
+///       Chunks average about 80 KiB.
+auto content_defined_chunk(std::string_view text) -> std::size_t;
+
+#endif  // EG_HASH_H
@@ -0,0 +1,82 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Counting letters and violations instead of converting them.
+
+#include "histogram.h"
+
+#include <iterator>
+
+#include <fmt/format.h>
+
+void histogram::add(sanitized_token const& token)
+{
+  if (token.error == violation::none) {
+    letters[std::size_t(token.letters.letter - 'A')] += token.letters.length;
+  }
+  else {
+    add(token.error);
+  }
+}
+
+void histogram::add(violation error)
+{
+  switch (error) {
+    case violation::none:
+      return;
+    case violation::unrecognized:
+      ++unrecognized;
+      return;
+    case violation::out_of_range:
+      ++out_of_range;
+      return;
+  }
+}
+
+auto histogram::operator+=(histogram const& other) -> histogram&
+{
+  for (std::size_t i{0}; i != letters.size(); ++i) {
+    letters[i] += other.letters[i];
+  }
+  unrecognized += other.unrecognized;
+  out_of_range += other.out_of_range;
+  return *this;
+}
+
+void write_histogram(histogram const& counts, writer& output)
+{
+  for (auto number{min_number}; number <= max_number; ++number) {
+    fmt::format_to(
+        std::back_inserter(output), "{} {}\n", number_to_letter(number), counts.letters[number - min_number]);
+  }
+  fmt::format_to(std::back_inserter(output), "{} {}\n", violation_name(violation::unrecognized), counts.unrecognized);
+  fmt::format_to(std::back_inserter(output), "{} {}\n", violation_name(violation::out_of_range), counts.out_of_range);
+}
+
+void write_histogram_ndjson(histogram const& counts, writer& output)
+{
+  output.push_back('{');
+  for (auto number{min_number}; number <= max_number; ++number) {
+    fmt::format_to(
+        std::back_inserter(output), R"("{}":{},)", number_to_letter(number), counts.letters[number - min_number]);
+  }
+  fmt::format_to(
+      std::back_inserter(output),
+      R"("{}":{},"{}":{}}})",
+      violation_name(violation::unrecognized),
+      counts.unrecognized,
+      violation_name(violation::out_of_range),
+      counts.out_of_range);
+  output.push_back('\n');
+}
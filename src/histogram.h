@@ -0,0 +1,51 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Counting letters and violations instead of converting them.
+
+#if !defined(EG_HISTOGRAM_H)
+#define EG_HISTOGRAM_H
+
+#include "letter.h"
+#include "token.h"
+#include "writer.h"
+
+#include <array>
+#include <cstdint>
+
+/// @brief how many times each letter and each violation occurred in some input
+struct histogram {
+  /// occurrences of each letter, starting with 'A'
+  std::array<std::uint64_t, max_number - min_number + 1> letters{};
+
+  std::uint64_t unrecognized{0};
+  std::uint64_t out_of_range{0};
+
+  /// @brief count the letters denoted by a sanitized token, or its violation
+  void add(sanitized_token const& token);
+
+  /// @brief count a violation
+  void add(violation error);
+
+  auto operator+=(histogram const& other) -> histogram&;
+};
+
+/// @brief Write one line for each letter, then one for each violation, e.g. "C 5".
+/// @note Every letter is listed, even those which did not occur, so the output has a fixed shape.
+void write_histogram(histogram const& counts, writer& output);
+
+/// @brief Write one JSON object mapping each letter and each violation to its count.
+void write_histogram_ndjson(histogram const& counts, writer& output);
+
+#endif  // EG_HISTOGRAM_H
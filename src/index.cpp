@@ -0,0 +1,197 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file A sparse index from the lines of batch input
+///       to the output and diagnostics they produced.
+
+#include "index.h"
+#include "echo.h"
+#include "file.h"
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace {
+  constexpr auto magic{std::string_view{"EGINDEX1"}};
+  constexpr std::size_t field_size{sizeof(std::uint64_t)};
+  constexpr std::size_t header_size{magic.size() + 2 * field_size};
+  constexpr std::size_t entry_size{2 * field_size};
+  constexpr auto bits_per_byte{8U};
+
+  void store(char* destination, std::uint64_t value)
+  {
+    for (auto i{0U}; i != field_size; ++i) {
+      destination[i] = char(value >> (i * bits_per_byte));
+    }
+  }
+
+  auto load(char const* source)
+  {
+    std::uint64_t value{0};
+    for (auto i{0U}; i != field_size; ++i) {
+      value |= std::uint64_t(static_cast<unsigned char>(source[i])) << (i * bits_per_byte);
+    }
+    return value;
+  }
+
+  auto make_header(std::uint64_t num_lines)
+  {
+    std::array<char, header_size> header{};
+    magic.copy(header.data(), magic.size());
+    store(header.data() + magic.size(), index_stride);
+    store(header.data() + magic.size() + field_size, num_lines);
+    return header;
+  }
+
+  /// @brief read exactly enough bytes to fill `destination`, starting at `offset`
+  /// @return true iff all of the bytes were read
+  auto read_at(std::FILE* file, std::uint64_t offset, std::span<char> destination)
+  {
+    return std::fseek(file, long(offset), SEEK_SET) == 0
+        && std::fread(destination.data(), 1, destination.size(), file) == destination.size();
+  }
+
+  /// @brief read the bytes in range [begin, end) of a file named by the user
+  /// @return the bytes, or nothing if the file could not be read
+  auto read_block(char const* path, std::string_view role, std::uint64_t begin, std::uint64_t end)
+      -> std::optional<std::vector<char>>
+  {
+    auto const file{open_file(path, "rb", role)};
+    if (!file) {
+      return std::nullopt;
+    }
+
+    std::vector<char> block(end >= begin ? end - begin : 0);
+    if (end < begin || !read_at(file.get(), begin, block)) {
+      fmt::print(stderr, "Truncated {} file, {}\n", role, quote_path(path));
+      return std::nullopt;
+    }
+    return block;
+  }
+
+  /// @return the line of `text` after the first `n` newlines, without its own newline
+  auto nth_line(std::string_view text, std::uint64_t n)
+  {
+    for (; n != 0 && !text.empty(); --n) {
+      auto const newline{text.find('\n')};
+      text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+    }
+    return text.substr(0, text.find('\n'));
+  }
+}
+
+index_writer::index_writer(std::FILE* file)
+    : file_{file}
+    , entries_{file}
+{
+  // The line count isn't known until the end; `finish` fills it in.
+  auto const header{make_header(0)};
+  entries_.write({header.data(), header.size()});
+}
+
+auto index_writer::finish(std::uint64_t output_offset, std::uint64_t error_offset) -> bool
+{
+  write_entry(output_offset, error_offset);
+  if (!entries_.flush()) {
+    return false;
+  }
+
+  auto const header{make_header(num_lines_)};
+  return std::fseek(file_, 0, SEEK_SET) == 0 && std::fwrite(header.data(), 1, header.size(), file_) == header.size()
+      && std::fflush(file_) == 0;
+}
+
+void index_writer::write_entry(std::uint64_t output_offset, std::uint64_t error_offset)
+{
+  std::array<char, entry_size> entry{};
+  store(entry.data(), output_offset);
+  store(entry.data() + field_size, error_offset);
+  entries_.write({entry.data(), entry.size()});
+}
+
+auto unsanitized_lookup(
+    std::uint64_t line_number, char const* index_path, char const* output_path, char const* error_log_path)
+    -> outcome
+{
+  auto const index{open_file(index_path, "rb", "index")};
+  if (!index) {
+    return outcome::usage_error;
+  }
+
+  // Verify that the index is one of ours.
+  std::array<char, header_size> header{};
+  if (!read_at(index.get(), 0, header) || std::string_view{header.data(), magic.size()} != magic
+      || load(header.data() + magic.size()) == 0) {
+    // End User Contract violation; emit diagnostic and exit with non-zero exit code
+    fmt::print(stderr, "Unrecognized index file, {}\n", quote_path(index_path));
+    return outcome::usage_error;
+  }
+  auto const stride{load(header.data() + magic.size())};
+  auto const num_lines{load(header.data() + magic.size() + field_size)};
+
+  // Verify the range of the line number.
+  if (line_number < 1 || line_number > num_lines) {
+    // End User Contract violation; emit diagnostic and exit with non-zero exit code
+    fmt::print(stderr, "Out-of-range line number, {}\n", line_number);
+    return outcome::usage_error;
+  }
+
+  // Fetch the entries at either end of the block containing the line.
+  auto const block{(line_number - 1) / stride};
+  auto const line_in_block{(line_number - 1) % stride};
+  std::array<char, 2 * entry_size> entries{};
+  if (!read_at(index.get(), header_size + block * entry_size, entries)) {
+    fmt::print(stderr, "Truncated index file, {}\n", quote_path(index_path));
+    return outcome::usage_error;
+  }
+  auto const* const first{entries.data()};
+  auto const* const last{entries.data() + entry_size};
+
+  auto const output{read_block(output_path, "output", load(first), load(last))};
+  if (!output) {
+    return outcome::usage_error;
+  }
+  fmt::print("{}\n", nth_line({output->data(), output->size()}, line_in_block));
+  std::fflush(stdout);
+
+  if (error_log_path == nullptr) {
+    return outcome::success;
+  }
+
+  auto const errors{read_block(error_log_path, "error log", load(first + field_size), load(last + field_size))};
+  if (!errors) {
+    return outcome::usage_error;
+  }
+
+  // The line's diagnostics are the ones prefixed with its number.
+  auto const prefix{fmt::format("{}:", line_number)};
+  auto found{false};
+  for (auto text{std::string_view{errors->data(), errors->size()}}; !text.empty();) {
+    auto const diagnostic{text.substr(0, text.find('\n'))};
+    if (diagnostic.starts_with(prefix)) {
+      fmt::print(stderr, "{}\n", diagnostic);
+      found = true;
+    }
+    text.remove_prefix(std::min(diagnostic.size() + 1, text.size()));
+  }
+
+  return found ? outcome::input_error : outcome::success;
+}
@@ -0,0 +1,72 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file A sparse index from the lines of batch input
+///       to the output and diagnostics they produced.
+/// @note The index is a header followed by an entry for every `index_stride`th line
+///       and one more entry marking the end of the output and error log.
+///       Each entry holds the offsets of a line's output and of its first diagnostic.
+///       Integers are stored as 64-bit little-endian.
+
+#if !defined(EG_INDEX_H)
+#define EG_INDEX_H
+
+#include "outcome.h"
+#include "writer.h"
+
+#include <cstdint>
+#include <cstdio>
+
+/// @brief the number of lines between entries in the index
+constexpr std::uint64_t index_stride{1024};
+
+/// @brief Records where the output and diagnostics of each line begin.
+class index_writer {
+public:
+  /// @pre file is open for writing and is seekable
+  explicit index_writer(std::FILE* file);
+
+  /// @brief note the offsets at which the output and diagnostics of the next line begin
+  void start_line(std::uint64_t output_offset, std::uint64_t error_offset)
+  {
+    if (num_lines_ % index_stride == 0) {
+      write_entry(output_offset, error_offset);
+    }
+    ++num_lines_;
+  }
+
+  /// @brief write the end entry and the final line count
+  /// @return true iff every write to the index succeeded
+  auto finish(std::uint64_t output_offset, std::uint64_t error_offset) -> bool;
+
+private:
+  void write_entry(std::uint64_t output_offset, std::uint64_t error_offset);
+
+  std::FILE* file_;
+  writer entries_;
+  std::uint64_t num_lines_{0};
+};
+
+/// @brief Print what one line of input produced during an indexed batch run.
+/// @param line_number the line of input, counting from 1
+/// @param index_path null-terminated name of the index file
+/// @param output_path null-terminated name of the output file
+/// @param error_log_path null-terminated name of the error log, or null
+/// @note The line's output is printed to stdout and its diagnostics to stderr, as they were originally.
+///       Only the few blocks of each file which cover the line are read.
+auto unsanitized_lookup(
+    std::uint64_t line_number, char const* index_path, char const* output_path, char const* error_log_path)
+    -> outcome;
+
+#endif  // EG_INDEX_H
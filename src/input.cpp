@@ -0,0 +1,678 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Reading batch input which may be compressed.
+
+#include "input.h"
+#include "eg_assert.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(EG_HAVE_ZLIB)
+#define ZLIB_CONST
+#include <zlib.h>
+#endif
+
+#if defined(EG_HAVE_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace {
+  enum class compression {
+    none,
+    gzip,
+    zstd,
+  };
+
+  auto detect(std::span<char const> prefix)
+  {
+    auto const starts_with = [prefix](std::initializer_list<unsigned char> magic) {
+      return prefix.size() >= magic.size()
+          && std::equal(magic.begin(), magic.end(), prefix.begin(), [](unsigned char m, char c) {
+               return m == static_cast<unsigned char>(c);
+             });
+    };
+
+    if (starts_with({0x1f, 0x8b})) {
+      return compression::gzip;
+    }
+    if (starts_with({0x28, 0xb5, 0x2f, 0xfd})) {
+      return compression::zstd;
+    }
+    return compression::none;
+  }
+
+  /// @brief A fixed ring of buffers passed from one producer thread to one consumer thread
+  /// @note The buffers are allocated up front and recycled.
+  class buffer_queue {
+  public:
+    buffer_queue(std::size_t num_slots, std::size_t slot_size)
+        : slots_(num_slots, std::vector<char>(slot_size))
+        , sizes_(num_slots)
+    {
+    }
+
+    /// @brief wait for an empty buffer
+    /// @return the buffer, or an empty span if the consumer has gone away
+    auto begin_write() -> std::span<char>
+    {
+      std::unique_lock lock{mutex_};
+      changed_.wait(lock, [this] { return num_full_ != slots_.size() || cancelled_; });
+      if (cancelled_) {
+        return {};
+      }
+      return slots_[write_];
+    }
+
+    /// @brief pass the first `size` bytes of the buffer from `begin_write` to the consumer
+    void end_write(std::size_t size)
+    {
+      if (size == 0) {
+        // An empty buffer would look like the end of input; keep it for next time.
+        return;
+      }
+      {
+        std::scoped_lock lock{mutex_};
+        sizes_[write_] = size;
+        write_ = (write_ + 1) % slots_.size();
+        ++num_full_;
+      }
+      changed_.notify_all();
+    }
+
+    /// @brief signal the end of the input
+    /// @param error a description of the error which ended the input early, if any
+    void close(std::string error)
+    {
+      {
+        std::scoped_lock lock{mutex_};
+        closed_ = true;
+        error_ = std::move(error);
+      }
+      changed_.notify_all();
+    }
+
+    /// @brief wait for a full buffer
+    /// @return the buffer, or an empty span at the end of input
+    auto begin_read() -> std::span<char const>
+    {
+      std::unique_lock lock{mutex_};
+      changed_.wait(lock, [this] { return num_full_ != 0 || closed_; });
+      if (num_full_ == 0) {
+        return {};
+      }
+      return {slots_[read_].data(), sizes_[read_]};
+    }
+
+    /// @brief return the buffer from `begin_read` to the producer
+    void end_read()
+    {
+      {
+        std::scoped_lock lock{mutex_};
+        read_ = (read_ + 1) % slots_.size();
+        --num_full_;
+      }
+      changed_.notify_all();
+    }
+
+    /// @brief tell the producer to stop
+    void cancel()
+    {
+      {
+        std::scoped_lock lock{mutex_};
+        cancelled_ = true;
+      }
+      changed_.notify_all();
+    }
+
+    [[nodiscard]] auto error() -> std::string
+    {
+      std::scoped_lock lock{mutex_};
+      return error_;
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::vector<std::vector<char>> slots_;
+    std::vector<std::size_t> sizes_;
+    std::size_t write_{0};
+    std::size_t read_{0};
+    std::size_t num_full_{0};
+    bool closed_{false};
+    bool cancelled_{false};
+    std::string error_;
+  };
+
+  /// @brief Compressed input, buffered so that whole blocks can be examined at once
+  class compressed_reader {
+  public:
+    compressed_reader(std::FILE* file, std::span<char const> prefix)
+        : file_{file}
+        , buffer_(std::max(initial_capacity, prefix.size()))
+        , end_{prefix.size()}
+    {
+      std::copy(prefix.begin(), prefix.end(), buffer_.begin());
+    }
+
+    /// @return the bytes read but not yet consumed
+    [[nodiscard]] auto data() const -> std::span<char const>
+    {
+      return {buffer_.data() + begin_, end_ - begin_};
+    }
+
+    /// @return true iff the whole file has been read
+    [[nodiscard]] auto eof() const
+    {
+      return eof_;
+    }
+
+    [[nodiscard]] auto error() const -> std::string const&
+    {
+      return error_;
+    }
+
+    /// @brief read until at least `size` bytes are unconsumed or the file ends
+    /// @return false iff there was a read error
+    auto fill(std::size_t size) -> bool
+    {
+      if (end_ - begin_ >= size || eof_) {
+        return true;
+      }
+
+      std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+      end_ -= begin_;
+      begin_ = 0;
+      if (buffer_.size() < size) {
+        buffer_.resize(size);
+      }
+
+      while (end_ < size && !eof_) {
+        auto const num_read{std::fread(buffer_.data() + end_, 1, buffer_.size() - end_, file_)};
+        end_ += num_read;
+        if (num_read == 0) {
+          if (std::ferror(file_) != 0) {
+            error_ = std::strerror(errno);
+            return false;
+          }
+          eof_ = true;
+        }
+      }
+      return true;
+    }
+
+    void consume(std::size_t size)
+    {
+      eg_assert(size <= end_ - begin_);
+      begin_ += size;
+    }
+
+  private:
+    static constexpr std::size_t initial_capacity{std::size_t{1} << 20U};
+
+    std::FILE* file_;
+    std::vector<char> buffer_;
+    std::size_t begin_{0};
+    std::size_t end_;
+    bool eof_{false};
+    std::string error_;
+  };
+
+  /// @brief an independently decompressible part of the input whose decompressed size is known
+  struct block {
+    std::size_t offset;
+    std::size_t compressed_size;
+    std::size_t size;
+  };
+
+  /// @brief the result of looking for a block at the start of some input
+  enum class search_result {
+    found,
+    need_more_input,
+    not_a_block,
+  };
+
+  using block_finder = auto (*)(std::span<char const> data, block& result) -> search_result;
+  using block_decoder = auto (*)(std::span<char const> compressed, std::span<char> destination) -> bool;
+
+  /// @brief Decompress leading blocks of known size, several at once, until the input is not made of them.
+  /// @return true iff the input was used up, else streaming decompression should take over
+  auto decode_blocks(
+      compressed_reader& input,
+      buffer_queue& output,
+      unsigned num_threads,
+      block_finder find,
+      block_decoder decode,
+      std::string& error)
+  {
+    std::vector<block> blocks;
+    while (true) {
+      auto const destination{output.begin_write()};
+      if (destination.empty()) {
+        return true;
+      }
+
+      // Gather as many blocks as will fit in the buffer.
+      blocks.clear();
+      std::size_t offset{0};
+      std::size_t size{0};
+      while (true) {
+        block found;
+        auto const result{find(input.data().subspan(offset), found)};
+        if (result == search_result::need_more_input && !input.eof()) {
+          if (!input.fill(2 * input.data().size() + 1)) {
+            error = input.error();
+            return true;
+          }
+          continue;
+        }
+        if (result != search_result::found || size + found.size > destination.size()) {
+          break;
+        }
+        found.offset = offset;
+        blocks.push_back(found);
+        offset += found.compressed_size;
+        size += found.size;
+      }
+
+      if (blocks.empty()) {
+        return input.eof() && input.data().empty();
+      }
+
+      // Decompress the blocks side by side.
+      std::atomic<bool> valid{true};
+      auto const compressed{input.data()};
+      auto const decode_some = [&](std::size_t first) {
+        auto destination_offset{std::size_t{0}};
+        for (std::size_t i{0}; i != blocks.size(); ++i) {
+          auto const& b{blocks[i]};
+          if (i % num_threads == first
+              && !decode(compressed.subspan(b.offset, b.compressed_size), destination.subspan(destination_offset, b.size))) {
+            valid = false;
+          }
+          destination_offset += b.size;
+        }
+      };
+      {
+        std::vector<std::jthread> workers;
+        for (auto worker{1U}; worker < num_threads && worker < blocks.size(); ++worker) {
+          workers.emplace_back(decode_some, worker);
+        }
+        decode_some(0);
+      }
+      if (!valid) {
+        error = "invalid compressed data";
+        return true;
+      }
+
+      input.consume(offset);
+      output.end_write(size);
+    }
+  }
+
+  /// @return the little-endian integer made of `num_bytes` bytes of `data` from `offset`
+  auto load_le(std::span<char const> data, std::size_t offset, std::size_t num_bytes)
+  {
+    constexpr auto bits_per_byte{8U};
+    std::uint32_t value{0};
+    for (std::size_t i{0}; i != num_bytes; ++i) {
+      value |= std::uint32_t{static_cast<unsigned char>(data[offset + i])} << (i * bits_per_byte);
+    }
+    return value;
+  }
+
+#if defined(EG_HAVE_ZLIB)
+  constexpr auto gzip_window_bits{MAX_WBITS + 16};
+
+  /// @brief find a BGZF block: a gzip member whose header records its compressed size
+  auto find_bgzf_block(std::span<char const> data, block& result) -> search_result
+  {
+    // ID1 ID2 CM FLG MTIME(4) XFL OS XLEN(2)
+    constexpr std::size_t fixed_header_size{12};
+    constexpr std::size_t subfield_header_size{4};
+    constexpr std::size_t trailer_size{8};
+    constexpr auto deflate{8U};
+    constexpr auto extra_flag{4U};
+
+    if (data.size() < fixed_header_size) {
+      return search_result::need_more_input;
+    }
+    if (load_le(data, 0, 2) != 0x8b1fU || load_le(data, 2, 1) != deflate || (load_le(data, 3, 1) & extra_flag) == 0) {
+      return search_result::not_a_block;
+    }
+
+    auto const extra_end{fixed_header_size + load_le(data, fixed_header_size - 2, 2)};
+    if (data.size() < extra_end) {
+      return search_result::need_more_input;
+    }
+
+    for (auto subfield{fixed_header_size}; subfield + subfield_header_size <= extra_end;) {
+      auto const subfield_size{load_le(data, subfield + 2, 2)};
+      if (data[subfield] == 'B' && data[subfield + 1] == 'C' && subfield_size == 2
+          && subfield + subfield_header_size + 2 <= extra_end) {
+        std::size_t const member_size{load_le(data, subfield + subfield_header_size, 2) + 1U};
+        if (member_size < extra_end + trailer_size) {
+          return search_result::not_a_block;
+        }
+        if (data.size() < member_size) {
+          return search_result::need_more_input;
+        }
+        result = block{0, member_size, load_le(data, member_size - 4, 4)};
+        return search_result::found;
+      }
+      subfield += subfield_header_size + subfield_size;
+    }
+
+    return search_result::not_a_block;
+  }
+
+  auto decode_gzip_member(std::span<char const> compressed, std::span<char> destination) -> bool
+  {
+    z_stream stream{};
+    if (inflateInit2(&stream, gzip_window_bits) != Z_OK) {
+      return false;
+    }
+    stream.next_in = reinterpret_cast<Bytef const*>(compressed.data());
+    stream.avail_in = uInt(compressed.size());
+    stream.next_out = reinterpret_cast<Bytef*>(destination.data());
+    stream.avail_out = uInt(destination.size());
+    auto const status{inflate(&stream, Z_FINISH)};
+    auto const size{stream.total_out};
+    inflateEnd(&stream);
+    return status == Z_STREAM_END && size == destination.size();
+  }
+
+  /// @brief decompress a gzip stream, which may be made of several members, on this thread
+  /// @return a description of any error
+  auto inflate_stream(compressed_reader& input, buffer_queue& output) -> std::string
+  {
+    z_stream stream{};
+    if (inflateInit2(&stream, gzip_window_bits) != Z_OK) {
+      return "out of memory";
+    }
+    auto const end{std::unique_ptr<z_stream, decltype(&inflateEnd)>{&stream, inflateEnd}};
+
+    auto member_ended{false};
+    while (true) {
+      auto const destination{output.begin_write()};
+      if (destination.empty()) {
+        return {};
+      }
+      stream.next_out = reinterpret_cast<Bytef*>(destination.data());
+      stream.avail_out = uInt(destination.size());
+      auto const publish = [&] { output.end_write(destination.size() - stream.avail_out); };
+
+      while (stream.avail_out != 0) {
+        if (input.data().empty()) {
+          if (!input.fill(1)) {
+            publish();
+            return input.error();
+          }
+          if (input.data().empty()) {
+            publish();
+            return member_ended ? std::string{} : std::string{"truncated gzip data"};
+          }
+        }
+
+        auto const compressed{input.data()};
+        auto const available{uInt(std::min(compressed.size(), std::size_t{UINT_MAX}))};
+        stream.next_in = reinterpret_cast<Bytef const*>(compressed.data());
+        stream.avail_in = available;
+        auto const status{inflate(&stream, Z_NO_FLUSH)};
+        input.consume(available - stream.avail_in);
+
+        if (status == Z_STREAM_END) {
+          // Another member may follow.
+          member_ended = true;
+          inflateReset(&stream);
+        }
+        else if (status == Z_OK || status == Z_BUF_ERROR) {
+          member_ended = false;
+        }
+        else {
+          publish();
+          return stream.msg != nullptr ? stream.msg : "invalid gzip data";
+        }
+      }
+
+      publish();
+    }
+  }
+#endif
+
+#if defined(EG_HAVE_ZSTD)
+  /// @brief find a zstd frame which records its decompressed size
+  auto find_zstd_block(std::span<char const> data, block& result) -> search_result
+  {
+    constexpr std::size_t max_frame_header_size{18};
+
+    if (data.empty()) {
+      return search_result::need_more_input;
+    }
+
+    auto const content_size{ZSTD_getFrameContentSize(data.data(), data.size())};
+    if (content_size == ZSTD_CONTENTSIZE_ERROR) {
+      return data.size() < max_frame_header_size ? search_result::need_more_input : search_result::not_a_block;
+    }
+    if (content_size == ZSTD_CONTENTSIZE_UNKNOWN) {
+      return search_result::not_a_block;
+    }
+
+    auto const frame_size{ZSTD_findFrameCompressedSize(data.data(), data.size())};
+    if (ZSTD_isError(frame_size) != 0) {
+      // Most likely truncated; if not, streaming decompression will say what is wrong.
+      return search_result::need_more_input;
+    }
+
+    result = block{0, frame_size, std::size_t(content_size)};
+    return search_result::found;
+  }
+
+  auto decode_zstd_frame(std::span<char const> compressed, std::span<char> destination) -> bool
+  {
+    auto const size{ZSTD_decompress(destination.data(), destination.size(), compressed.data(), compressed.size())};
+    return ZSTD_isError(size) == 0 && size == destination.size();
+  }
+
+  /// @brief decompress a zstd stream, which may be made of several frames, on this thread
+  /// @return a description of any error
+  auto zstd_stream(compressed_reader& input, buffer_queue& output) -> std::string
+  {
+    auto const context{std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)>{ZSTD_createDCtx(), ZSTD_freeDCtx}};
+    if (!context) {
+      return "out of memory";
+    }
+
+    std::size_t frame_remaining{0};
+    while (true) {
+      auto const destination{output.begin_write()};
+      if (destination.empty()) {
+        return {};
+      }
+      ZSTD_outBuffer out{destination.data(), destination.size(), 0};
+
+      while (out.pos != out.size) {
+        if (input.data().empty()) {
+          if (!input.fill(1)) {
+            output.end_write(out.pos);
+            return input.error();
+          }
+          if (input.data().empty()) {
+            output.end_write(out.pos);
+            return frame_remaining == 0 ? std::string{} : std::string{"truncated zstd data"};
+          }
+        }
+
+        auto const compressed{input.data()};
+        ZSTD_inBuffer in{compressed.data(), compressed.size(), 0};
+        frame_remaining = ZSTD_decompressStream(context.get(), &out, &in);
+        input.consume(in.pos);
+        if (ZSTD_isError(frame_remaining) != 0) {
+          output.end_write(out.pos);
+          return ZSTD_getErrorName(frame_remaining);
+        }
+      }
+
+      output.end_write(out.pos);
+    }
+  }
+#endif
+}
+
+/// @brief Decompresses input on its own thread, ahead of the reader.
+class decompressor {
+public:
+  decompressor(compression format, std::FILE* file, std::span<char const> prefix, unsigned num_threads)
+      : queue_{num_slots, slot_size}
+      , input_{file, prefix}
+      , thread_{[this, format, num_threads] { queue_.close(decompress(format, num_threads)); }}
+  {
+  }
+
+  decompressor(decompressor const&) = delete;
+  decompressor(decompressor&&) = delete;
+  auto operator=(decompressor const&) -> decompressor& = delete;
+  auto operator=(decompressor&&) -> decompressor& = delete;
+
+  ~decompressor()
+  {
+    // Stop the thread early if the reader hasn't read everything.
+    queue_.cancel();
+  }
+
+  auto read(std::span<char> destination) -> std::size_t
+  {
+    while (current_.empty()) {
+      if (holding_) {
+        queue_.end_read();
+        holding_ = false;
+      }
+      current_ = queue_.begin_read();
+      if (current_.empty()) {
+        return 0;
+      }
+      holding_ = true;
+    }
+
+    auto const size{std::min(destination.size(), current_.size())};
+    std::memcpy(destination.data(), current_.data(), size);
+    current_ = current_.subspan(size);
+    return size;
+  }
+
+  [[nodiscard]] auto error() -> std::string
+  {
+    return queue_.error();
+  }
+
+private:
+  static constexpr std::size_t num_slots{4};
+  static constexpr std::size_t slot_size{std::size_t{1} << 22U};
+
+  /// @return a description of any error
+  auto decompress(compression format, unsigned num_threads) -> std::string
+  {
+    std::string error;
+    switch (format) {
+      case compression::gzip:
+#if defined(EG_HAVE_ZLIB)
+        if (num_threads > 1 && decode_blocks(input_, queue_, num_threads, find_bgzf_block, decode_gzip_member, error)) {
+          return error;
+        }
+        return inflate_stream(input_, queue_);
+#else
+        return "gzip-compressed input is not supported by this build";
+#endif
+      case compression::zstd:
+#if defined(EG_HAVE_ZSTD)
+        if (num_threads > 1 && decode_blocks(input_, queue_, num_threads, find_zstd_block, decode_zstd_frame, error)) {
+          return error;
+        }
+        return zstd_stream(input_, queue_);
+#else
+        return "zstd-compressed input is not supported by this build";
+#endif
+      case compression::none:
+        break;
+    }
+    eg_assert(false);
+    return error;
+  }
+
+  buffer_queue queue_;
+  compressed_reader input_;
+  std::span<char const> current_;
+  bool holding_{false};
+
+  // Last, so that the thread is joined before the other members are destroyed.
+  std::jthread thread_;
+};
+
+auto is_compressed(std::span<char const> prefix) -> bool
+{
+  return detect(prefix) != compression::none;
+}
+
+input_stream::input_stream(std::FILE* file, unsigned num_threads)
+    : file_{file}
+{
+  eg_assert(file != nullptr);
+  eg_assert(num_threads != 0);
+
+  // Peek at the first bytes to learn whether the input is compressed.
+  prefix_end_ = std::fread(prefix_.data(), 1, prefix_.size(), file);
+  auto const format{detect({prefix_.data(), prefix_end_})};
+  if (format != compression::none) {
+    decompressor_ = std::make_unique<decompressor>(format, file, std::span{prefix_.data(), prefix_end_}, num_threads);
+  }
+}
+
+input_stream::~input_stream() = default;
+
+auto input_stream::read(std::span<char> destination) -> std::size_t
+{
+  if (decompressor_) {
+    auto const size{decompressor_->read(destination)};
+    if (size == 0) {
+      error_ = decompressor_->error();
+    }
+    return size;
+  }
+
+  // Serve the bytes peeked at by the constructor first.
+  if (prefix_begin_ != prefix_end_) {
+    auto const size{std::min(destination.size(), prefix_end_ - prefix_begin_)};
+    std::memcpy(destination.data(), prefix_.data() + prefix_begin_, size);
+    prefix_begin_ += size;
+    return size;
+  }
+
+  auto const size{std::fread(destination.data(), 1, destination.size(), file_)};
+  if (size == 0 && std::ferror(file_) != 0) {
+    error_ = std::strerror(errno);
+  }
+  return size;
+}
@@ -0,0 +1,73 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Reading batch input which may be compressed.
+
+#if !defined(EG_INPUT_H)
+#define EG_INPUT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <span>
+#include <string>
+
+class decompressor;
+
+/// @return true iff `prefix`, the first bytes of some input, marks it as compressed in a format which is detected
+auto is_compressed(std::span<char const> prefix) -> bool;
+
+/// @brief A source of input bytes which transparently decompresses gzip and zstd.
+/// @note The compression format is detected from the first bytes of input.
+///       Compressed input is decompressed on a separate thread,
+///       which feeds buffers to the reader so that the two stages overlap.
+///       Input made of independent blocks of known size, such as BGZF or multi-frame zstd,
+///       is decompressed by several threads at once.
+class input_stream {
+public:
+  /// @param file the input, which must outlive this object
+  /// @param num_threads the number of threads which may decompress blocks in parallel
+  /// @pre num_threads is not zero
+  input_stream(std::FILE* file, unsigned num_threads);
+
+  input_stream(input_stream const&) = delete;
+  input_stream(input_stream&&) = delete;
+  auto operator=(input_stream const&) -> input_stream& = delete;
+  auto operator=(input_stream&&) -> input_stream& = delete;
+
+  ~input_stream();
+
+  /// @brief read up to `destination.size()` bytes
+  /// @return the number of bytes read, which is zero at the end of input or after an error
+  auto read(std::span<char> destination) -> std::size_t;
+
+  /// @return a description of the error which ended the input, or an empty string
+  [[nodiscard]] auto error() const -> std::string const&
+  {
+    return error_;
+  }
+
+private:
+  static constexpr std::size_t max_magic_size{4};
+
+  std::FILE* file_;
+  std::array<char, max_magic_size> prefix_{};
+  std::size_t prefix_begin_{0};
+  std::size_t prefix_end_{0};
+  std::unique_ptr<decompressor> decompressor_;
+  std::string error_;
+};
+
+#endif  // EG_INPUT_H
@@ -0,0 +1,134 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Just enough JSON to read and write newline-delimited records.
+
+#include "json.h"
+#include "scan.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include <fmt/format.h>
+
+namespace {
+  using namespace std::literals::string_view_literals;
+
+  constexpr auto npos{std::string_view::npos};
+  constexpr auto whitespace{" \t\r\n"sv};
+
+  /// @return the position of the quote which closes the string opened at `open`, or `npos`
+  auto string_end(std::string_view line, std::size_t open)
+  {
+    for (auto close{line.find('"', open + 1)}; close != npos; close = line.find('"', close + 1)) {
+      // The quote is escaped iff it follows an odd number of backslashes.
+      auto const backslashes{close - 1 - line.find_last_not_of('\\', close - 1)};
+      if (backslashes % 2 == 0) {
+        return close;
+      }
+    }
+    return npos;
+  }
+}
+
+auto find_member(std::string_view line, std::string_view name) -> std::optional<std::string_view>
+{
+  byte_finder<'"', '{', '}', '[', ']'> structure{line};
+  auto depth{0};
+  for (auto position{structure.next()}; position != npos; position = structure.next()) {
+    switch (line[position]) {
+      case '{':
+      case '[':
+        ++depth;
+        continue;
+      case '}':
+      case ']':
+        --depth;
+        continue;
+      default:
+        break;
+    }
+
+    // Skip over the string, noting whether it names the member.
+    auto const close{string_end(line, position)};
+    if (close == npos) {
+      return std::nullopt;
+    }
+    structure.seek(close + 1);
+    if (depth != 1 || line.substr(position + 1, close - position - 1) != name) {
+      continue;
+    }
+
+    auto const colon{line.find_first_not_of(whitespace, close + 1)};
+    if (colon == npos || line[colon] != ':') {
+      // The name was a value, not a key.
+      continue;
+    }
+
+    auto const value{line.find_first_not_of(whitespace, colon + 1)};
+    if (value == npos) {
+      return std::nullopt;
+    }
+    if (line[value] == '"') {
+      auto const value_close{string_end(line, value)};
+      if (value_close == npos) {
+        return std::nullopt;
+      }
+      return line.substr(value, value_close + 1 - value);
+    }
+    auto const value_end{std::min(line.find_first_of(",}] \t\r\n"sv, value), line.size())};
+    return line.substr(value, value_end - value);
+  }
+
+  return std::nullopt;
+}
+
+void write_json_string(writer& output, std::string_view text)
+{
+  constexpr auto first_printable{0x20};
+
+  output.push_back('"');
+  while (!text.empty()) {
+    // Copy everything up to the next character which needs escaping in one go.
+    auto const plain{std::find_if(text.begin(), text.end(), [](char c) {
+      return c == '"' || c == '\\' || static_cast<unsigned char>(c) < first_printable;
+    })};
+    auto const plain_size{std::size_t(plain - text.begin())};
+    output.write(text.substr(0, plain_size));
+    text.remove_prefix(plain_size);
+    if (text.empty()) {
+      break;
+    }
+
+    switch (auto const c{text.front()}) {
+      case '"':
+        output.write(R"(\")"sv);
+        break;
+      case '\\':
+        output.write(R"(\\)"sv);
+        break;
+      case '\n':
+        output.write(R"(\n)"sv);
+        break;
+      case '\t':
+        output.write(R"(\t)"sv);
+        break;
+      default:
+        fmt::format_to(std::back_inserter(output), "\\u{:04x}", unsigned(static_cast<unsigned char>(c)));
+        break;
+    }
+    text.remove_prefix(1);
+  }
+  output.push_back('"');
+}
@@ -0,0 +1,36 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Just enough JSON to read and write newline-delimited records.
+
+#if !defined(EG_JSON_H)
+#define EG_JSON_H
+
+#include "writer.h"
+
+#include <optional>
+#include <string_view>
+
+/// @brief Find the value of a member of the top-level object on a line of JSON.
+/// @param line one JSON object
+/// @param name the name of the member, which must not need escaping
+/// @return the text of the value, including any quotes, or nothing if no such member was found
+/// @note Only as much structure as is needed to find the member is parsed;
+///       nested values and the rest of the line are skipped, not validated.
+auto find_member(std::string_view line, std::string_view name) -> std::optional<std::string_view>;
+
+/// @brief write `text` as a quoted JSON string, escaping as necessary
+void write_json_string(writer& output, std::string_view text);
+
+#endif  // EG_JSON_H
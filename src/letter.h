@@ -0,0 +1,52 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file The 'business logic' of the program: mapping positions to letters.
+
+#if !defined(EG_LETTER_H)
+#define EG_LETTER_H
+
+#include "eg_assert.h"
+
+constexpr auto min_number{1};
+constexpr auto max_number{26};
+
+/// @brief The letter at the given position in the English alphabet
+/// @param number the position of the letter in the alphabet
+/// @return the letter at that give position as uppercase
+/// @note The position of the first letter, 'A', is 1
+/// @note It can be implied from this description
+///       that values <1 or >26 violate the contract of this API.
+///       Regardless of the assertions within the function,
+///       a program in which the contract is violates
+///       should be considered to exhibit undefined behavior.
+///       However, it rarely hurts to clarify contracts...
+/// @pre  number is in range [1..26]
+constexpr auto number_to_letter(int number)
+{
+  // Assertions - and not logical checks - are appropriate here.
+  // They are here to help analysis tools, such as UBSan, detect bugs.
+  // They can also server as documentation.
+  eg_assert(number >= min_number);
+  eg_assert(number <= max_number);
+
+  // Just because we can reason about the behavior of
+  // this implementation of the function doesn't mean
+  // its behavior is defined when its contract is violated.
+  // For example, the API provider reserves the right
+  // to implement the function with a lookup table.
+  return char(number - min_number + 'A');
+}
+
+#endif  // EG_LETTER_H
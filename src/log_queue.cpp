@@ -0,0 +1,157 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file A queue of diagnostic text, written to a file by a thread of its own.
+
+#include "log_queue.h"
+#include "eg_assert.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+#include <vector>
+
+log_queue::log_queue(std::FILE* file, overflow policy, std::size_t num_slots)
+    : file_{file}
+    , policy_{policy}
+    , mask_{num_slots - 1}
+    , slots_{new slot[num_slots]}
+{
+  eg_assert(file != nullptr);
+  eg_assert(num_slots != 0 && (num_slots & mask_) == 0);
+
+  for (std::size_t position{0}; position != num_slots; ++position) {
+    slots_[position].sequence.store(position, std::memory_order_relaxed);
+  }
+  consumer_ = std::jthread{[this] {
+    // Signals are left to the threads which handle them, e.g. the one following a file,
+    // which may only block them after this thread has started.
+    sigset_t signals;
+    sigfillset(&signals);
+    ::pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    consume();
+  }};
+}
+
+log_queue::~log_queue()
+{
+  stopped_.store(true, std::memory_order_release);
+  num_pushed_.fetch_add(1, std::memory_order_release);
+  num_pushed_.notify_one();
+}
+
+auto log_queue::push(std::string_view text) -> bool
+{
+  auto pushed{true};
+  for (; text.size() > slot_size; text.remove_prefix(slot_size)) {
+    pushed &= push_slot(text.substr(0, slot_size));
+  }
+  if (!text.empty()) {
+    pushed &= push_slot(text);
+  }
+  return pushed;
+}
+
+auto log_queue::flush() -> bool
+{
+  // Everything this thread put in the queue is before the next position to be claimed.
+  auto const target{tail_.load(std::memory_order_relaxed)};
+  for (auto written{written_.load(std::memory_order_acquire)}; written < target;
+       written = written_.load(std::memory_order_acquire)) {
+    written_.wait(written, std::memory_order_acquire);
+  }
+  return !failed_.load(std::memory_order_relaxed);
+}
+
+auto log_queue::push_slot(std::string_view text) -> bool
+{
+  auto waited{false};
+  auto position{tail_.load(std::memory_order_relaxed)};
+  for (;;) {
+    auto& claimed{slots_[position & mask_]};
+    auto const sequence{claimed.sequence.load(std::memory_order_acquire)};
+    if (sequence == position) {
+      // The slot is free; claim it unless another producer got there first.
+      if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        std::memcpy(claimed.text.data(), text.data(), text.size());
+        claimed.size = text.size();
+        claimed.sequence.store(position + 1, std::memory_order_release);
+        num_pushed_.fetch_add(1, std::memory_order_release);
+        num_pushed_.notify_one();
+        return true;
+      }
+    }
+    else if (sequence < position) {
+      // The queue is full.
+      if (policy_ == overflow::drop) {
+        num_dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      if (!waited) {
+        num_waits_.fetch_add(1, std::memory_order_relaxed);
+        waited = true;
+      }
+      auto const written{written_.load(std::memory_order_acquire)};
+      if (written + mask_ < position) {
+        written_.wait(written, std::memory_order_acquire);
+      }
+      position = tail_.load(std::memory_order_relaxed);
+    }
+    else {
+      // Another producer claimed the slot.
+      position = tail_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void log_queue::consume()
+{
+  // Text is gathered from as many slots as are full and written at once.
+  std::vector<char> batch;
+  batch.reserve(slot_size * 16);
+  std::size_t head{0};
+
+  for (;;) {
+    auto const num_pushed{num_pushed_.load(std::memory_order_acquire)};
+    auto const stopped{stopped_.load(std::memory_order_acquire)};
+
+    for (;;) {
+      auto& taken{slots_[head & mask_]};
+      if (taken.sequence.load(std::memory_order_acquire) != head + 1) {
+        break;
+      }
+      batch.insert(batch.end(), taken.text.data(), taken.text.data() + taken.size);
+      taken.sequence.store(head + mask_ + 1, std::memory_order_release);
+      ++head;
+      if (batch.size() + slot_size > batch.capacity()) {
+        break;
+      }
+    }
+
+    if (batch.empty()) {
+      if (stopped) {
+        return;
+      }
+      num_pushed_.wait(num_pushed, std::memory_order_acquire);
+      continue;
+    }
+
+    if (std::fwrite(batch.data(), 1, batch.size(), file_) != batch.size() || std::fflush(file_) != 0) {
+      failed_.store(true, std::memory_order_relaxed);
+    }
+    batch.clear();
+    written_.store(head, std::memory_order_release);
+    written_.notify_all();
+  }
+}
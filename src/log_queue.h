@@ -0,0 +1,131 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file A queue of diagnostic text, written to a file by a thread of its own.
+
+#if !defined(EG_LOG_QUEUE_H)
+#define EG_LOG_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string_view>
+#include <thread>
+
+/// @brief A bounded, lock-free queue into which any number of threads put text,
+///        which a background thread takes out in batches and writes to a file.
+/// @note Putting text in the queue costs a copy and a few atomic operations, unless the queue is full.
+///       Then it either waits for the background thread to make room (back-pressure) or drops the text,
+///       counting either event.
+/// @note Text is kept whole and in order if it fits in a slot, i.e. `slot_size` bytes;
+///       longer text is split, and its parts may be interleaved with text put by other threads.
+/// @note The background thread blocks every signal, so that none is delivered to it.
+class log_queue {
+public:
+  /// the most text held by each slot of the queue
+  static constexpr std::size_t slot_size{4096 - 2 * sizeof(std::size_t)};
+
+  /// the number of slots, which must be a power of two
+  static constexpr std::size_t default_num_slots{256};
+
+  /// @brief what `push` does when the queue is full
+  enum class overflow {
+    /// wait for room, so that no text is lost
+    wait,
+
+    /// drop the text, so that the caller is never held up
+    drop,
+  };
+
+  /// @pre file is open for writing
+  /// @pre num_slots is a power of two
+  explicit log_queue(std::FILE* file, overflow policy = overflow::wait, std::size_t num_slots = default_num_slots);
+
+  log_queue(log_queue const&) = delete;
+  log_queue(log_queue&&) = delete;
+  auto operator=(log_queue const&) -> log_queue& = delete;
+  auto operator=(log_queue&&) -> log_queue& = delete;
+
+  /// @brief Write everything in the queue, then stop the background thread.
+  ~log_queue();
+
+  /// @brief Put text in the queue; safe to call from any number of threads at once.
+  /// @return false iff some of the text was dropped
+  auto push(std::string_view text) -> bool;
+
+  /// @brief Wait until the text which this thread has put in the queue has been written and flushed.
+  /// @return true iff every write so far has succeeded
+  auto flush() -> bool;
+
+  /// @return the file to which text is written
+  [[nodiscard]] auto file() const
+  {
+    return file_;
+  }
+
+  /// @return the number of pieces of text which were dropped because the queue was full
+  [[nodiscard]] auto num_dropped() const -> std::uint64_t
+  {
+    return num_dropped_.load(std::memory_order_relaxed);
+  }
+
+  /// @return the number of times `push` waited for room
+  [[nodiscard]] auto num_waits() const -> std::uint64_t
+  {
+    return num_waits_.load(std::memory_order_relaxed);
+  }
+
+private:
+  /// @brief one entry of the queue
+  /// @note `sequence` says whose turn it is to use the slot:
+  ///       the producer whose position equals it, or the consumer when it is one greater.
+  struct slot {
+    std::atomic<std::size_t> sequence;
+    std::size_t size;
+    std::array<char, slot_size> text;
+  };
+
+  /// @brief put up to `slot_size` bytes in the queue
+  auto push_slot(std::string_view text) -> bool;
+
+  /// @brief take text out of the queue and write it, until stopped
+  void consume();
+
+  std::FILE* file_;
+  overflow policy_;
+  std::size_t mask_;
+  std::unique_ptr<slot[]> slots_;
+
+  /// the position of the next slot to be claimed by a producer
+  alignas(64) std::atomic<std::size_t> tail_{0};
+
+  /// incremented whenever a producer fills a slot, for the consumer to wait on
+  alignas(64) std::atomic<std::uint32_t> num_pushed_{0};
+
+  /// the position up to which text has been written, for producers to wait on
+  alignas(64) std::atomic<std::size_t> written_{0};
+
+  std::atomic<bool> stopped_{false};
+  std::atomic<bool> failed_{false};
+  std::atomic<std::uint64_t> num_dropped_{0};
+  std::atomic<std::uint64_t> num_waits_{0};
+
+  // Last, so that the thread is joined before the queue is destroyed
+  std::jthread consumer_;
+};
+
+#endif  // EG_LOG_QUEUE_H
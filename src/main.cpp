@@ -15,69 +15,27 @@
 /// @file An example of a robust C++ program.
 /// @note Please read accompanying comments for explanations...
 
+#include "batch.h"
+#include "echo.h"
+#include "letter.h"
+#include "outcome.h"
+#include "telemetry.h"
+
 #include <charconv>
+#include <chrono>
 #include <cstdlib>
-#include <exception>
 #include <span>
 #include <string_view>
 
 #include <fmt/printf.h>
 
-/// @brief A minimal assertion function for testing API contracts.
-/// @note This function lacks diagnostics and may not be suitable
-///       for defective or safety-critical applications.
-constexpr void eg_assert(bool condition)
-{
-  if (condition) {
-    return;
-  }
-
-#if defined(LOG_AND_CONTINUE_STRATEGY)
-  fmt::print(stderr, "a C++ API violation occurred\n");
-#elif defined(TRAP_STRATEGY)
-  std::terminate();
-#elif defined(PREVENTION_STRATEGY)
-  __builtin_unreachable();
-#else
-#error missing strategy pre-processor definition
-#endif
-}
-
-constexpr auto min_number{1};
-constexpr auto max_number{26};
-
-/// @brief The letter at the given position in the English alphabet
-/// @param number the position of the letter in the alphabet
-/// @return the letter at that give position as uppercase
-/// @note The position of the first letter, 'A', is 1
-/// @note It can be implied from this description
-///       that values <1 or >26 violate the contract of this API.
-///       Regardless of the assertions within the function,
-///       a program in which the contract is violates
-///       should be considered to exhibit undefined behavior.
-///       However, it rarely hurts to clarify contracts...
-/// @pre  number is in range [1..26]
-constexpr auto number_to_letter(int number)
-{
-  // Assertions - and not logical checks - are appropriate here.
-  // They are here to help analysis tools, such as UBSan, detect bugs.
-  // They can also server as documentation.
-  eg_assert(number >= min_number);
-  eg_assert(number <= max_number);
-
-  // Just because we can reason about the behavior of
-  // this implementation of the function doesn't mean
-  // its behavior is defined when its contract is violated.
-  // For example, the API provider reserves the right
-  // to implement the function with a lookup table.
-  return char(number - min_number + 'A');
-}
-
 /// @brief Execute the 'business logic' of the program, after sanitization.
 /// @pre Requires sanitized data, i.e. number in the range 1<=number<=26.
 /// @note This function is safe to make assumptions about the data.
 /// @note Any `@pre` precondition violation is a C++ API Contract violation.
-void sanitized_run(int number)
+/// @note Marked hot, as is `unsanitized_run`, so that the linker places them beside `main`
+///       and a single conversion touches fewer pages of the program.
+[[gnu::hot]] void sanitized_run(int number)
 {
   fmt::print("{}", number_to_letter(number));
 }
@@ -85,7 +43,8 @@ void sanitized_run(int number)
 /// @brief Sanitize the user input, testing user violation of End User Contract
 ///        before passing sanitized input to the 'business logic' of the program.
 /// @param args program arguments (excluding executable itself)
-/// @return true iff the function was able to do its job
+/// @param run what the run did, for telemetry
+/// @return whether the function was able to do its job and, if not, why not
 /// @pre arguments are null-terminated strings
 /// @note There are no assumptions about the contents of
 ///       the strings passed into this function.
@@ -97,18 +56,25 @@ void sanitized_run(int number)
 ///       `std::span` in inherentely safer than `main` parameters.
 ///       Type-safety and static checking is generally better
 ///       than run-time contract and dynamic checking.
-auto unsanitized_run(std::span<char*> args)
+[[gnu::hot]] auto unsanitized_run(std::span<char*> args, invocation& run)
 {
   using namespace std::literals::string_view_literals;
 
+  // Batch mode takes its own arguments.
+  if (!args.empty() && std::string_view{args[0]} == "--batch"sv) {
+    run.kind = invocation_kind::batch;
+    return unsanitized_batch_run(args.subspan(1));
+  }
+
   // Verify correct number of arguments.
   constexpr auto expected_num_params{1};
   auto const actual_num_params{args.size()};
   if (actual_num_params != expected_num_params) {
     // End User Contract violation; emit diagnostic and exit with non-zero exit code
+    run.rejected = rejection::wrong_number_of_arguments;
     fmt::print(
         stderr, "Wrong number of arguments provided. Expected={}; Actual={}\n", expected_num_params, actual_num_params);
-    return false;
+    return outcome::usage_error;
   }
 
   // Print help text if requested.
@@ -119,7 +85,13 @@ auto unsanitized_run(std::span<char*> args)
     fmt::print("This program prints the letter of the alphabet at the given position.\n");
     fmt::print("Usage: letter N\n");
     fmt::print("N: number between {} and {}\n", min_number, max_number);
-    return true;
+    return outcome::success;
+  }
+
+  // Print the counters which runs add to as they exit.
+  if (argument == "--telemetry-dump"sv) {
+    run.kind = invocation_kind::telemetry_dump;
+    return dump_telemetry();
   }
 
   // Convert the argument to a number.
@@ -128,22 +100,25 @@ auto unsanitized_run(std::span<char*> args)
   auto [ptr, ec] = std::from_chars(std::begin(argument), std::end(argument), number);
   if (ec == std::errc::invalid_argument || ptr != std::end(argument)) {
     // End User Contract violation; emit diagnostic and exit with non-zero exit code
-    fmt::print(stderr, "Unrecognized number, '{}'\n", argument);
-    return false;
+    run.rejected = rejection::unrecognized_number;
+    fmt::print(stderr, "Unrecognized number, {}\n", quote_input(argument));
+    return outcome::usage_error;
   }
 
   // Verify the range of number.
   if (number < min_number || number > max_number) {
     // End User Contract violation; emit diagnostic and exit with non-zero exit code
+    run.rejected = rejection::out_of_range_number;
     fmt::print(stderr, "Out-of-range number, {}\n", number);
-    return false;
+    return outcome::usage_error;
   }
 
   // The input is now successfully sanitized. If the program gets this far,
   // the End User Contract was not violated by the user.
   sanitized_run(number);
+  run.letter = number_to_letter(number);
 
-  return true;
+  return outcome::success;
 }
 
 /// @brief program entry point
@@ -151,10 +126,24 @@ auto unsanitized_run(std::span<char*> args)
 /// @note We should **not** assume that the End User Contract is not violated by calls to main.
 auto main(int argc, char* argv[]) -> int
 {
-  if (!unsanitized_run(std::span{argv + 1, std::size_t(argc) - 1U})) {
-    fmt::print("Try --help\n");
-    return EXIT_FAILURE;
+  auto const start{std::chrono::steady_clock::now()};
+
+  invocation run;
+  run.result = unsanitized_run(std::span{argv + 1, std::size_t(argc) - 1U}, run);
+  run.wall_time = std::chrono::steady_clock::now() - start;
+  record_telemetry(run);
+
+  switch (run.result) {
+    case outcome::success:
+      return EXIT_SUCCESS;
+    case outcome::usage_error:
+      fmt::print("Try --help\n");
+      return EXIT_FAILURE;
+    case outcome::input_error:
+      // The diagnostics have already said what was wrong with the input.
+      return EXIT_FAILURE;
   }
 
-  return EXIT_SUCCESS;
+  // Unreachable but compilers don't always agree.
+  return EXIT_FAILURE;
 }
@@ -0,0 +1,104 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Helpers for sanitizing the options of the program's modes.
+
+#if !defined(EG_OPTIONS_H)
+#define EG_OPTIONS_H
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+#include <fmt/printf.h>
+
+/// @brief A minimal parser of `--name`, `--name=value` and `--name value` arguments
+/// @note A missing value is diagnosed here; test `failed` once parsing is done.
+class option_parser {
+public:
+  explicit option_parser(std::span<char*> args)
+      : args_{args}
+  {
+  }
+
+  /// @return true iff there are arguments left to parse
+  [[nodiscard]] explicit operator bool() const
+  {
+    return !failed_ && next_ != args_.size();
+  }
+
+  /// @return true iff an error was diagnosed
+  [[nodiscard]] auto failed() const
+  {
+    return failed_;
+  }
+
+  /// @return the next argument, without consuming it
+  [[nodiscard]] auto peek() const
+  {
+    return next_ == args_.size() ? std::string_view{} : std::string_view{args_[next_]};
+  }
+
+  /// @return the next argument, consuming it
+  /// @pre there are arguments left to parse
+  auto positional() -> char*
+  {
+    return args_[next_++];
+  }
+
+  /// @brief consume the next argument if it is the given flag
+  /// @return true iff the next argument was the given flag
+  auto flag(std::string_view name) -> bool
+  {
+    if (peek() != name) {
+      return false;
+    }
+    ++next_;
+    return true;
+  }
+
+  /// @brief consume the next argument, and possibly its value, if it is the given option
+  /// @return the value of the option if it is the next argument, else null
+  auto value(std::string_view name) -> char const*
+  {
+    auto const argument{peek()};
+    if (!argument.starts_with(name)) {
+      return nullptr;
+    }
+
+    if (argument.size() == name.size()) {
+      ++next_;
+      if (next_ == args_.size()) {
+        // End User Contract violation; emit diagnostic and stop parsing
+        fmt::print(stderr, "Missing value of option, '{}'\n", name);
+        failed_ = true;
+        return "";
+      }
+      return args_[next_++];
+    }
+
+    if (argument[name.size()] == '=') {
+      return args_[next_++] + name.size() + 1;
+    }
+
+    return nullptr;
+  }
+
+private:
+  std::span<char*> args_;
+  std::size_t next_{0};
+  bool failed_{false};
+};
+
+#endif  // EG_OPTIONS_H
@@ -0,0 +1,35 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file The result of running the program, as seen by `main`.
+
+#if !defined(EG_OUTCOME_H)
+#define EG_OUTCOME_H
+
+/// @brief How a run of the program ended
+/// @note Both kinds of error are End User Contract violations
+///       and both result in a non-zero exit code.
+///       They differ only in whether the user is pointed at the help text.
+enum class outcome {
+  /// the program did its job
+  success,
+
+  /// the program was invoked incorrectly, e.g. with a bad argument
+  usage_error,
+
+  /// the program was invoked correctly but some of the data it read was bad
+  input_error,
+};
+
+#endif  // EG_OUTCOME_H
@@ -0,0 +1,233 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Quoting untrusted input, without allocating or depending on the C library.
+/// @note The freestanding build of the program uses this directly; other code uses `quote_input` in echo.h.
+
+#if !defined(EG_QUOTE_H)
+#define EG_QUOTE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/// @brief a Unicode character decoded from UTF-8
+struct code_point {
+  char32_t value;
+
+  /// the number of bytes it was encoded in, or zero if the encoding was invalid
+  std::size_t size;
+};
+
+/// @brief Decode the UTF-8 character at the start of `text`, which does not begin with an ASCII byte.
+constexpr auto decode_utf8(std::string_view text) -> code_point
+{
+  constexpr auto continuation_mask{0xc0U};
+  constexpr auto continuation{0x80U};
+  constexpr auto payload_bits{6U};
+
+  auto const lead{unsigned{static_cast<unsigned char>(text[0])}};
+
+  // The number of continuation bytes, the bits of the lead byte and the smallest value for that size
+  std::size_t num_continuations{0};
+  char32_t value{0};
+  char32_t min_value{0};
+  if (lead >= 0xc2U && lead <= 0xdfU) {
+    num_continuations = 1;
+    value = lead & 0x1fU;
+    min_value = 0x80;
+  }
+  else if (lead >= 0xe0U && lead <= 0xefU) {
+    num_continuations = 2;
+    value = lead & 0x0fU;
+    min_value = 0x800;
+  }
+  else if (lead >= 0xf0U && lead <= 0xf4U) {
+    num_continuations = 3;
+    value = lead & 0x07U;
+    min_value = 0x10000;
+  }
+  else {
+    return {0, 0};
+  }
+
+  if (text.size() <= num_continuations) {
+    return {0, 0};
+  }
+  for (std::size_t i{1}; i <= num_continuations; ++i) {
+    auto const byte{unsigned{static_cast<unsigned char>(text[i])}};
+    if ((byte & continuation_mask) != continuation) {
+      return {0, 0};
+    }
+    value = (value << payload_bits) | (byte & ~continuation_mask);
+  }
+
+  // Reject overlong encodings, surrogates and values beyond Unicode.
+  constexpr char32_t first_surrogate{0xd800};
+  constexpr char32_t last_surrogate{0xdfff};
+  constexpr char32_t max_value{0x10ffff};
+  if (value < min_value || (value >= first_surrogate && value <= last_surrogate) || value > max_value) {
+    return {0, 0};
+  }
+  return {value, num_continuations + 1};
+}
+
+/// @return true iff the character can change how the surrounding text is displayed
+constexpr auto is_unsafe(char32_t value)
+{
+  // C1 control characters
+  constexpr char32_t first_c1{0x80};
+  constexpr char32_t last_c1{0x9f};
+
+  // bidirectional formatting characters, which can make text appear in a different order than it is stored
+  constexpr char32_t first_mark{0x200e};
+  constexpr char32_t last_mark{0x200f};
+  constexpr char32_t first_embedding{0x202a};
+  constexpr char32_t last_embedding{0x202e};
+  constexpr char32_t first_isolate{0x2066};
+  constexpr char32_t last_isolate{0x2069};
+
+  return (value >= first_c1 && value <= last_c1) || (value >= first_mark && value <= last_mark)
+      || (value >= first_embedding && value <= last_embedding) || (value >= first_isolate && value <= last_isolate);
+}
+
+/// @return true iff the byte is echoed as it is
+constexpr auto is_plain(unsigned char c)
+{
+  constexpr unsigned char first_printable{0x20};
+  constexpr unsigned char last_printable{0x7e};
+  return c >= first_printable && c <= last_printable && c != '\'' && c != '\\';
+}
+
+/// @return true iff every byte of the block can be echoed as it is
+/// @note The test has no branches, so compilers can vectorize it.
+constexpr auto is_plain_block(std::string_view block)
+{
+  auto plain{true};
+  for (auto const c : block) {
+    plain &= is_plain(static_cast<unsigned char>(c));
+  }
+  return plain;
+}
+
+/// @brief Append `value` to `sink` in hexadecimal, with at least `num_digits` digits.
+template<typename Sink>
+constexpr void append_hex(Sink& sink, std::uint32_t value, int num_digits)
+{
+  constexpr auto bits_per_digit{4};
+  constexpr auto digits{"0123456789abcdef"};
+  for (auto shift{bits_per_digit * 7}; shift >= 0; shift -= bits_per_digit) {
+    if ((value >> unsigned(shift)) != 0 || shift < bits_per_digit * num_digits) {
+      sink.push_back(digits[(value >> unsigned(shift)) & 0xfU]);
+    }
+  }
+}
+
+/// @brief Append `value` to `sink` in decimal.
+template<typename Sink>
+constexpr void append_decimal(Sink& sink, std::uint64_t value)
+{
+  constexpr auto max_digits{20};
+  char digits[max_digits];
+  auto num_digits{0};
+  do {
+    digits[num_digits++] = char('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  while (num_digits != 0) {
+    sink.push_back(digits[--num_digits]);
+  }
+}
+
+/// @brief Append `text`, quoted as described by `quote_input` in echo.h, to `sink`.
+/// @tparam Sink has `append(std::string_view)` and `push_back(char)`
+template<typename Sink>
+constexpr void append_quoted(Sink& sink, std::string_view text, std::size_t limit)
+{
+  /// the number of bytes tested at once for the common case of plain text
+  constexpr std::size_t block_size{16};
+
+  sink.push_back('\'');
+
+  auto rest{text.substr(0, limit)};
+  while (!rest.empty()) {
+    // Copy plain text a block at a time.
+    if (rest.size() >= block_size && is_plain_block(rest.substr(0, block_size))) {
+      sink.append(rest.substr(0, block_size));
+      rest.remove_prefix(block_size);
+      continue;
+    }
+
+    auto const c{static_cast<unsigned char>(rest.front())};
+    if (is_plain(c)) {
+      sink.push_back(char(c));
+      rest.remove_prefix(1);
+      continue;
+    }
+
+    switch (c) {
+      case '\'':
+        sink.append(R"(\')");
+        rest.remove_prefix(1);
+        continue;
+      case '\\':
+        sink.append(R"(\\)");
+        rest.remove_prefix(1);
+        continue;
+      case '\t':
+        sink.append(R"(\t)");
+        rest.remove_prefix(1);
+        continue;
+      case '\n':
+        sink.append(R"(\n)");
+        rest.remove_prefix(1);
+        continue;
+      case '\r':
+        sink.append(R"(\r)");
+        rest.remove_prefix(1);
+        continue;
+      default:
+        break;
+    }
+
+    constexpr unsigned char first_non_ascii{0x80};
+    if (c >= first_non_ascii) {
+      if (auto const decoded{decode_utf8(rest)}; decoded.size != 0) {
+        if (is_unsafe(decoded.value)) {
+          sink.append(R"(\u)");
+          append_hex(sink, std::uint32_t{decoded.value}, 4);
+        }
+        else {
+          sink.append(rest.substr(0, decoded.size));
+        }
+        rest.remove_prefix(decoded.size);
+        continue;
+      }
+    }
+
+    // A control character, or a byte which is not part of valid UTF-8
+    sink.append(R"(\x)");
+    append_hex(sink, c, 2);
+    rest.remove_prefix(1);
+  }
+
+  sink.push_back('\'');
+  if (text.size() > limit) {
+    sink.append("... (");
+    append_decimal(sink, text.size());
+    sink.append(" bytes)");
+  }
+}
+
+#endif  // EG_QUOTE_H
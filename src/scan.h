@@ -0,0 +1,98 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Locating a few chosen characters in text, a block at a time.
+
+#if !defined(EG_SCAN_H)
+#define EG_SCAN_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+/// @brief Iterates over the positions of the given characters in a text.
+/// @note Each block of text is classified with branch-free comparisons,
+///       which compilers turn into vector instructions,
+///       and only the matching characters are then visited one at a time.
+template <char... Chars>
+class byte_finder {
+public:
+  static constexpr std::size_t block_size{64};
+  static constexpr auto npos{std::string_view::npos};
+
+  explicit byte_finder(std::string_view text, std::size_t position = 0)
+      : text_{text}
+  {
+    seek(position);
+  }
+
+  /// @brief continue the search from `position`
+  void seek(std::size_t position)
+  {
+    base_ = position;
+    mask_ = classify(position);
+  }
+
+  /// @return the position of the next of the characters, or `npos` if there are none left
+  auto next() -> std::size_t
+  {
+    while (mask_ == 0) {
+      base_ += block_size;
+      if (base_ >= text_.size()) {
+        return npos;
+      }
+      mask_ = classify(base_);
+    }
+
+    auto const position{base_ + std::size_t(std::countr_zero(mask_))};
+    mask_ &= mask_ - 1;
+    return position;
+  }
+
+private:
+  static constexpr auto is_chosen(char c)
+  {
+    return ((c == Chars) || ...);
+  }
+
+  /// @return a bit for each of the next `block_size` bytes from `position`, set iff it is chosen
+  [[nodiscard]] auto classify(std::size_t position) const -> std::uint64_t
+  {
+    if (position >= text_.size()) {
+      return 0;
+    }
+
+    auto const* const block{text_.data() + position};
+    std::uint64_t mask{0};
+    if (text_.size() - position >= block_size) {
+      // A fixed trip count and no early exit make this loop easy to vectorize.
+      for (std::size_t i{0}; i != block_size; ++i) {
+        mask |= std::uint64_t{is_chosen(block[i])} << i;
+      }
+    }
+    else {
+      for (std::size_t i{0}; i != text_.size() - position; ++i) {
+        mask |= std::uint64_t{is_chosen(block[i])} << i;
+      }
+    }
+    return mask;
+  }
+
+  std::string_view text_;
+  std::size_t base_{0};
+  std::uint64_t mask_{0};
+};
+
+#endif  // EG_SCAN_H
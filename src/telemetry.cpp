@@ -0,0 +1,242 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Counters shared by every run of the program, for statistics across many concurrent runs.
+
+#include "telemetry.h"
+#include "echo.h"
+#include "fields.h"
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#include <fmt/printf.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  using namespace std::literals::string_view_literals;
+
+  constexpr auto letters{"ABCDEFGHIJKLMNOPQRSTUVWXYZ"sv};
+
+  /// @brief the position of each counter in the telemetry file
+  enum counter : std::size_t {
+    invocations,
+    batch_invocations,
+    successes,
+    usage_errors,
+    input_errors,
+    wrong_number_of_arguments,
+    unrecognized_numbers,
+    out_of_range_numbers,
+    wall_time_ns,
+
+    /// one counter per letter converted, from A to Z
+    first_letter,
+
+    num_counters = first_letter + letters.size(),
+  };
+
+  /// the names of the counters before the letters, as printed by `--telemetry-dump`
+  constexpr std::array<std::string_view, first_letter> names{
+      "invocations"sv,
+      "batch-invocations"sv,
+      "successes"sv,
+      "usage-errors"sv,
+      "input-errors"sv,
+      "wrong-number-of-arguments"sv,
+      "unrecognized-numbers"sv,
+      "out-of-range-numbers"sv,
+      "wall-time-ns"sv,
+  };
+
+  /// identifies a telemetry file with this layout
+  constexpr std::uint64_t format{0x4547'5445'4c45'0000U | num_counters};
+
+  /// @brief the contents of the telemetry file
+  /// @note The counters are only ever incremented, so their order of update does not matter.
+  struct segment {
+    std::atomic<std::uint64_t> format;
+    std::array<std::atomic<std::uint64_t>, num_counters> counters;
+  };
+
+  // Other processes map the same counters, so they must not be implemented with a lock.
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+  /// @brief a shared mapping of the telemetry file
+  class mapped_segment {
+  public:
+    /// @param writable if true, create and map the file for writing; otherwise it must exist
+    mapped_segment(char const* path, bool writable)
+    {
+      auto const fd{::open(path, writable ? O_RDWR | O_CREAT | O_CLOEXEC : O_RDONLY | O_CLOEXEC, 0666)};
+      if (fd == -1) {
+        error_ = errno;
+        return;
+      }
+
+      // A new file is extended with zeros, which are counters of zero.
+      struct stat status {};
+      if (::fstat(fd, &status) != 0) {
+        error_ = errno;
+      }
+      else if (status.st_size < off_t{sizeof(segment)} && !writable) {
+        error_ = EINVAL;
+      }
+      else if (status.st_size < off_t{sizeof(segment)} && ::ftruncate(fd, off_t{sizeof(segment)}) != 0) {
+        error_ = errno;
+      }
+      else {
+        auto const protection{writable ? PROT_READ | PROT_WRITE : PROT_READ};
+        auto* const address{::mmap(nullptr, sizeof(segment), protection, MAP_SHARED, fd, 0)};
+        if (address == MAP_FAILED) {
+          error_ = errno;
+        }
+        else {
+          segment_ = static_cast<segment*>(address);
+        }
+      }
+      ::close(fd);
+    }
+
+    mapped_segment(mapped_segment const&) = delete;
+    mapped_segment(mapped_segment&&) = delete;
+    auto operator=(mapped_segment const&) -> mapped_segment& = delete;
+    auto operator=(mapped_segment&&) -> mapped_segment& = delete;
+
+    ~mapped_segment()
+    {
+      if (segment_ != nullptr) {
+        ::munmap(segment_, sizeof(segment));
+      }
+    }
+
+    /// @return the mapped counters, or null if the file could not be mapped
+    [[nodiscard]] auto get() const -> segment*
+    {
+      return segment_;
+    }
+
+    /// @return the `errno` value describing why the file could not be mapped
+    [[nodiscard]] auto error() const
+    {
+      return error_;
+    }
+
+  private:
+    segment* segment_{nullptr};
+    int error_{0};
+  };
+
+  void increment(segment& counters, std::size_t index, std::uint64_t amount = 1)
+  {
+    counters.counters[index].fetch_add(amount, std::memory_order_relaxed);
+  }
+}
+
+void record_telemetry(invocation const& run)
+{
+  auto const* const path{std::getenv(telemetry_variable)};
+  if (path == nullptr || *path == '\0' || run.kind == invocation_kind::telemetry_dump) {
+    return;
+  }
+
+  auto const mapping{mapped_segment{path, true}};
+  auto* const counters{mapping.get()};
+  if (counters == nullptr) {
+    return;
+  }
+
+  // The first run to map a new file claims it; a file with another layout is left alone.
+  auto existing{std::uint64_t{0}};
+  if (!counters->format.compare_exchange_strong(existing, format) && existing != format) {
+    return;
+  }
+
+  increment(*counters, invocations);
+  if (run.kind == invocation_kind::batch) {
+    increment(*counters, batch_invocations);
+  }
+
+  switch (run.result) {
+    case outcome::success:
+      increment(*counters, successes);
+      break;
+    case outcome::usage_error:
+      increment(*counters, usage_errors);
+      break;
+    case outcome::input_error:
+      increment(*counters, input_errors);
+      break;
+  }
+
+  switch (run.rejected) {
+    case rejection::none:
+      break;
+    case rejection::wrong_number_of_arguments:
+      increment(*counters, wrong_number_of_arguments);
+      break;
+    case rejection::unrecognized_number:
+      increment(*counters, unrecognized_numbers);
+      break;
+    case rejection::out_of_range_number:
+      increment(*counters, out_of_range_numbers);
+      break;
+  }
+
+  if (auto const letter{letters.find(run.letter)}; run.letter != '\0' && letter != std::string_view::npos) {
+    increment(*counters, first_letter + letter);
+  }
+
+  increment(*counters, wall_time_ns, std::uint64_t(run.wall_time.count()));
+}
+
+auto dump_telemetry() -> outcome
+{
+  auto const* const path{std::getenv(telemetry_variable)};
+  if (path == nullptr || *path == '\0') {
+    fmt::print(stderr, "Option --telemetry-dump requires {} to name the telemetry file\n", telemetry_variable);
+    return outcome::usage_error;
+  }
+
+  auto const mapping{mapped_segment{path, false}};
+  auto const* const counters{mapping.get()};
+  if (counters == nullptr) {
+    fmt::print(stderr, "Failed to open telemetry file, {}: {}\n", quote_path(path), std::strerror(mapping.error()));
+    return outcome::input_error;
+  }
+  if (auto const found{counters->format.load(std::memory_order_relaxed)}; found != format && found != 0) {
+    fmt::print(stderr, "Unrecognized telemetry file, {}\n", quote_path(path));
+    return outcome::input_error;
+  }
+
+  std::array<std::uint64_t, num_counters> values{};
+  std::array<field, num_counters> fields{};
+  for (std::size_t index{0}; index != num_counters; ++index) {
+    values[index] = counters->counters[index].load(std::memory_order_relaxed);
+    auto const name{index < first_letter ? names[index] : letters.substr(index - first_letter, 1)};
+    fields[index] = field{name, &values[index]};
+  }
+  return write_fields(stdout, fields) ? outcome::success : outcome::input_error;
+}
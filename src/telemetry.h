@@ -0,0 +1,70 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Counters shared by every run of the program, for statistics across many concurrent runs.
+
+#if !defined(EG_TELEMETRY_H)
+#define EG_TELEMETRY_H
+
+#include "outcome.h"
+
+#include <chrono>
+
+/// the environment variable naming the telemetry file; telemetry is off unless it is set
+constexpr char const* telemetry_variable{"EG_TELEMETRY"};
+
+/// @brief what a run was asked to do
+enum class invocation_kind {
+  /// convert the single position given as an argument
+  conversion,
+
+  /// convert with `--batch`
+  batch,
+
+  /// print the telemetry with `--telemetry-dump`, which is not itself counted
+  telemetry_dump,
+};
+
+/// @brief why the arguments of a conversion were rejected
+enum class rejection {
+  none,
+  wrong_number_of_arguments,
+  unrecognized_number,
+  out_of_range_number,
+};
+
+/// @brief what one run did, to be added to the telemetry as it exits
+struct invocation {
+  invocation_kind kind{invocation_kind::conversion};
+
+  /// the letter printed by a successful conversion, if any
+  char letter{'\0'};
+
+  rejection rejected{rejection::none};
+
+  outcome result{outcome::success};
+
+  std::chrono::nanoseconds wall_time{0};
+};
+
+/// @brief Add a run to the counters in the telemetry file named by `EG_TELEMETRY`, if it is set.
+/// @note The file is mapped into memory, creating it if necessary, and its counters are incremented atomically,
+///       so that any number of runs can share it without locks or a daemon.
+///       Telemetry is best-effort; if the file cannot be used, the run is not counted and nothing is reported.
+void record_telemetry(invocation const& run);
+
+/// @brief Print every counter in the telemetry file named by `EG_TELEMETRY` to stdout, as `name value` lines.
+auto dump_telemetry() -> outcome;
+
+#endif  // EG_TELEMETRY_H
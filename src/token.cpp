@@ -0,0 +1,142 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Sanitization of the individual tokens of batch input.
+
+#include "token.h"
+#include "letter.h"
+
+#include <charconv>
+#include <iterator>
+
+#include <fmt/format.h>
+
+auto sanitize_token(std::string_view token) -> sanitized_token
+{
+  sanitized_token result{violation::none, std::nullopt, token};
+
+  // Split off any repeat count.
+  int count{1};
+  if (auto const separator{token.find('x')}; separator != std::string_view::npos) {
+    auto const count_text{token.substr(0, separator)};
+    auto const* const count_end{count_text.data() + count_text.size()};
+    auto [ptr, ec] = std::from_chars(count_text.data(), count_end, count);
+    if (ec == std::errc::result_out_of_range && ptr == count_end && !count_text.starts_with('-')) {
+      // Recognizably a run length, but too big even for `int`.
+      result.error = violation::out_of_range;
+      result.number_text = token.substr(separator + 1);
+      return result;
+    }
+    if (ec != std::errc{} || ptr != count_end || count < 1) {
+      result.error = violation::unrecognized;
+      return result;
+    }
+    result.number_text = token.substr(separator + 1);
+    result.count = count;
+    if (std::size_t(count) > max_run_length) {
+      result.error = violation::out_of_range;
+      return result;
+    }
+  }
+
+  // Convert the number.
+  int number;
+  auto const* const number_end{result.number_text.data() + result.number_text.size()};
+  auto [ptr, ec] = std::from_chars(result.number_text.data(), number_end, number);
+  if (ec == std::errc::result_out_of_range && ptr == number_end) {
+    // Recognizably a number, but too big even for `int`.
+    result.error = violation::out_of_range;
+    return result;
+  }
+  if (ec != std::errc{} || ptr != number_end) {
+    result.error = violation::unrecognized;
+    return result;
+  }
+  result.number = number;
+
+  // Verify the range of number.
+  if (number < min_number || number > max_number) {
+    result.error = violation::out_of_range;
+    return result;
+  }
+
+  result.letters = run{number_to_letter(number), std::size_t(count)};
+  return result;
+}
+
+void report(sanitized_token const& result, std::string_view token, location where, writer& errors, std::size_t echo_limit)
+{
+  switch (result.error) {
+    case violation::none:
+      return;
+    case violation::unrecognized: {
+      fmt::memory_buffer quoted;
+      quote_input(quoted, token, echo_limit);
+      fmt::format_to(
+          std::back_inserter(errors),
+          "{}:{}: Unrecognized number, {}\n",
+          where.line,
+          where.column,
+          std::string_view{quoted.data(), quoted.size()});
+      return;
+    }
+    case violation::out_of_range:
+      if (result.count && std::size_t(*result.count) > max_run_length) {
+        fmt::format_to(
+            std::back_inserter(errors),
+            "{}:{}: Out-of-range run length, {} (at most {})\n",
+            where.line,
+            where.column,
+            *result.count,
+            max_run_length);
+      }
+      else if (auto const separator{token.find('x')}; separator != std::string_view::npos && !result.count) {
+        // The run length is too big even for `int`; its digits are safe to echo but there may be very many of them.
+        auto const count_text{token.substr(0, separator)};
+        fmt::format_to(
+            std::back_inserter(errors),
+            "{}:{}: Out-of-range run length, {}",
+            where.line,
+            where.column,
+            count_text.substr(0, echo_limit));
+        if (count_text.size() > echo_limit) {
+          fmt::format_to(std::back_inserter(errors), "... ({} bytes)", count_text.size());
+        }
+        fmt::format_to(std::back_inserter(errors), " (at most {})\n", max_run_length);
+      }
+      else if (result.number) {
+        fmt::format_to(
+            std::back_inserter(errors), "{}:{}: Out-of-range number, {}\n", where.line, where.column, *result.number);
+      }
+      else if (result.number_text.size() <= echo_limit) {
+        fmt::format_to(
+            std::back_inserter(errors),
+            "{}:{}: Out-of-range number, {}\n",
+            where.line,
+            where.column,
+            result.number_text);
+      }
+      else {
+        // The digits are safe to echo but there may be very many of them.
+        fmt::format_to(
+            std::back_inserter(errors),
+            "{}:{}: Out-of-range number, {}... ({} bytes)\n",
+            where.line,
+            where.column,
+            result.number_text.substr(0, echo_limit),
+            result.number_text.size());
+      }
+      return;
+  }
+}
@@ -0,0 +1,118 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Sanitization of the individual tokens of batch input.
+
+#if !defined(EG_TOKEN_H)
+#define EG_TOKEN_H
+
+#include "echo.h"
+#include "writer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+/// @brief the ways in which a token can violate the End User Contract
+enum class violation : std::uint8_t {
+  none,
+  unrecognized,
+  out_of_range,
+};
+
+/// @return the name of a violation, as used in machine-readable output
+/// @note The names follow the wording of the diagnostics, e.g. "Out-of-range number".
+constexpr auto violation_name(violation v) -> std::string_view
+{
+  switch (v) {
+    case violation::none:
+      return "none";
+    case violation::unrecognized:
+      return "unrecognized";
+    case violation::out_of_range:
+      return "out-of-range";
+  }
+  return "";
+}
+
+/// @brief what batch mode does with a bad token, once it has been reported
+enum class error_policy {
+  /// leave it out of the output
+  skip,
+
+  /// convert nothing after it
+  stop,
+
+  /// write `placeholder_letter` in its place, so that the output stays aligned with the input
+  placeholder,
+};
+
+/// written in place of each bad token with `error_policy::placeholder`
+constexpr char placeholder_letter{'?'};
+
+/// @brief where in the input a token was found
+struct location {
+  std::uint64_t line;
+  std::size_t column;
+};
+
+/// @brief a letter repeated one or more times
+struct run {
+  char letter;
+  std::size_t length;
+};
+
+/// the most copies of a position which a run, CxN, may denote;
+/// a longer run is out of range, so that one token cannot demand unbounded output
+constexpr std::size_t max_run_length{std::size_t{1} << 20U};
+
+/// @brief what was learned by sanitizing a token
+struct sanitized_token {
+  violation error{violation::none};
+
+  /// the number, unless it was unrecognized or too big for `int`
+  std::optional<int> number;
+
+  /// the text of the number, without any repeat count
+  std::string_view number_text;
+
+  /// the letters denoted by the token, if there was no violation
+  run letters{'\0', 0};
+
+  /// the repeat count, if the token had one which was recognized
+  std::optional<int> count{};
+};
+
+/// @brief Sanitize one token of input, testing user violation of End User Contract.
+/// @param token a number, N, or a run-length encoded number, CxN, denoting C copies of N
+/// @note A run is validated once, no matter how many letters it denotes.
+/// @note A run of more than `max_run_length` letters is out of range.
+/// @note There are no assumptions about the contents of the token.
+auto sanitize_token(std::string_view token) -> sanitized_token;
+
+/// @brief Emit the diagnostic for a token which was rejected by `sanitize_token`.
+/// @param result the result of sanitizing `token`
+/// @param token the text that was sanitized
+/// @param where the position of the token in the input
+/// @param errors destination of diagnostics
+/// @param echo_limit the most bytes of the token to echo back
+void report(
+    sanitized_token const& result,
+    std::string_view token,
+    location where,
+    writer& errors,
+    std::size_t echo_limit = default_echo_limit);
+
+#endif  // EG_TOKEN_H
@@ -0,0 +1,132 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Parameters of batch mode which affect only its speed, as measured on the current machine.
+
+#include "tuning.h"
+#include "fields.h"
+#include "file.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdlib>
+#include <string_view>
+
+#include <sys/stat.h>
+
+namespace {
+  using namespace std::literals::string_view_literals;
+
+  /// @return the fields of the tuning file, with their names
+  auto fields(tuning& parameters)
+  {
+    return std::array{
+        field{"threads"sv, &parameters.num_threads},
+        field{"chunk-size"sv, &parameters.chunk_size},
+        field{"buffer-size"sv, &parameters.buffer_size},
+        field{"parallel-threshold"sv, &parameters.parallel_threshold},
+    };
+  }
+
+  /// the smallest and largest sane value of a field
+  struct limits {
+    std::uint64_t min;
+    std::uint64_t max;
+  };
+
+  /// @return the limits of each field, in the order of `fields`
+  /// @note Zero would not work at all, and the largest values would exhaust memory or threads.
+  constexpr auto field_limits()
+  {
+    constexpr std::uint64_t kibibyte{std::uint64_t{1} << 10U};
+    constexpr std::uint64_t mebibyte{std::uint64_t{1} << 20U};
+    return std::array{
+        limits{1, max_threads},
+        limits{4 * kibibyte, mebibyte * kibibyte},
+        limits{4 * kibibyte, 64 * mebibyte},
+        limits{1, mebibyte * mebibyte},
+    };
+  }
+
+  /// @brief create a directory and any missing parents
+  auto make_directories(std::string const& path)
+  {
+    for (auto slash{path.find('/', 1)};; slash = path.find('/', slash + 1)) {
+      auto const directory{path.substr(0, slash)};
+      if (::mkdir(directory.c_str(), S_IRWXU | S_IRWXG | S_IRWXO) != 0 && errno != EEXIST) {
+        return false;
+      }
+      if (slash == std::string::npos) {
+        return true;
+      }
+    }
+  }
+}
+
+auto default_tuning_path() -> std::string
+{
+  auto const* const cache_home{std::getenv("XDG_CACHE_HOME")};
+  if (cache_home != nullptr && *cache_home != '\0') {
+    return std::string{cache_home} + "/eg-error-handling/tuning";
+  }
+  auto const* const home{std::getenv("HOME")};
+  if (home != nullptr && *home != '\0') {
+    return std::string{home} + "/.cache/eg-error-handling/tuning";
+  }
+  return {};
+}
+
+auto read_tuning(char const* path) -> std::optional<tuning>
+{
+  auto const file{unique_file{std::fopen(path, "rb")}};
+  if (!file) {
+    return std::nullopt;
+  }
+
+  tuning parameters;
+  auto const parameter_fields{fields(parameters)};
+  auto const valid = [](field const& f, limits const& range) {
+    return *f.value >= range.min && *f.value <= range.max;
+  };
+  if (!read_fields(file.get(), parameter_fields)
+      || !std::equal(parameter_fields.begin(), parameter_fields.end(), field_limits().begin(), valid)) {
+    errno = EINVAL;
+    return std::nullopt;
+  }
+  return parameters;
+}
+
+auto print_tuning(std::FILE* file, tuning const& parameters) -> bool
+{
+  auto copy{parameters};
+  return write_fields(file, fields(copy));
+}
+
+auto write_tuning(char const* path, tuning const& parameters) -> bool
+{
+  auto const path_text{std::string{path}};
+  auto const slash{path_text.rfind('/')};
+  if (slash != std::string::npos && slash != 0 && !make_directories(path_text.substr(0, slash))) {
+    return false;
+  }
+
+  auto const temporary_path{path_text + ".tmp"};
+  auto file{unique_file{std::fopen(temporary_path.c_str(), "wb")}};
+  if (!file) {
+    return false;
+  }
+  auto const written{print_tuning(file.get(), parameters) && std::fclose(file.release()) == 0};
+  return written && std::rename(temporary_path.c_str(), path) == 0;
+}
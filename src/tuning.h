@@ -0,0 +1,67 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Parameters of batch mode which affect only its speed, as measured on the current machine.
+
+#if !defined(EG_TUNING_H)
+#define EG_TUNING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <thread>
+
+/// @brief the most threads which may work at once, beyond which they would cost more than they gain
+constexpr std::uint64_t max_threads{1024};
+
+/// @brief the parameters which `--calibrate` chooses
+/// @note The defaults are used until the machine is calibrated.
+struct tuning {
+  /// the number of threads which may work on large input at once
+  std::uint64_t num_threads{
+      std::clamp(std::uint64_t{std::thread::hardware_concurrency()}, std::uint64_t{1}, max_threads)};
+
+  /// the bytes of input which each thread tallies at a time with `--histogram`
+  std::uint64_t chunk_size{std::uint64_t{1} << 20U};
+
+  /// the size of the buffers into which input is read and output is written
+  std::uint64_t buffer_size{std::uint64_t{1} << 16U};
+
+  /// input files smaller than this are worked on by one thread
+  std::uint64_t parallel_threshold{std::uint64_t{1} << 20U};
+};
+
+/// @return the file in which tuning is kept by default, under `$XDG_CACHE_HOME` or `~/.cache`,
+///         or an empty string if neither is known
+auto default_tuning_path() -> std::string;
+
+/// @brief Read tuning written by `write_tuning`.
+/// @param path null-terminated name of the tuning file
+/// @return the tuning, or nothing if the file could not be read, in which case errno describes the failure,
+///         or if it is not a tuning file or holds a value beyond sane limits, in which case errno is EINVAL
+/// @note The limits are 1 to 1024 threads, chunks of 4 KiB to 1 GiB, buffers of 4 KiB to 64 MiB,
+///       and a parallel threshold of 1 byte to 1 TiB.
+auto read_tuning(char const* path) -> std::optional<tuning>;
+
+/// @brief Write tuning in the format of a tuning file.
+/// @return true iff every write succeeded
+auto print_tuning(std::FILE* file, tuning const& parameters) -> bool;
+
+/// @brief Replace the tuning file, creating its directory if necessary.
+/// @return true on success; otherwise errno describes the failure
+auto write_tuning(char const* path, tuning const& parameters) -> bool;
+
+#endif  // EG_TUNING_H
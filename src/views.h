@@ -0,0 +1,359 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file Range adaptors for converting positions lazily, as part of larger range pipelines.
+/// @note For example, `text | views::parse_positions | views::to_letter`
+///       is a range of letters which is computed as it is iterated.
+
+#if !defined(EG_VIEWS_H)
+#define EG_VIEWS_H
+
+#include "bulk.h"
+#include "letter.h"
+#include "token.h"
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/// @brief a position read from text, and whether it violates the End User Contract
+struct parsed_position {
+  /// the number read, or zero if it was unrecognized or too big for `int`
+  int number{0};
+
+  violation error{violation::none};
+};
+
+/// @brief the letter at a position, or the reason why there is none
+struct letter_result {
+  /// the letter, or '\0' if there was a violation
+  char letter{'\0'};
+
+  violation error{violation::none};
+};
+
+/// @brief Sanitize and convert one position.
+constexpr auto to_letter_result(int position) -> letter_result
+{
+  if (position < min_number || position > max_number) {
+    return {'\0', violation::out_of_range};
+  }
+  return {number_to_letter(position), violation::none};
+}
+
+/// @brief Convert one parsed position, passing on any violation found while parsing it.
+constexpr auto to_letter_result(parsed_position position) -> letter_result
+{
+  if (position.error != violation::none) {
+    return {'\0', position.error};
+  }
+  return to_letter_result(position.number);
+}
+
+namespace views {
+  /// @brief The positions of a contiguous range of `int`, converted to letters a block at a time.
+  /// @note Each block is sanitized and converted by the bulk functions;
+  ///       only a block which holds an invalid position is converted one position at a time.
+  template<std::ranges::view V>
+  requires std::ranges::contiguous_range<V const> && std::ranges::sized_range<V const>
+      && std::same_as<std::ranges::range_value_t<V>, int>
+  class blocked_letter_view : public std::ranges::view_interface<blocked_letter_view<V>> {
+  public:
+    class iterator {
+    public:
+      using iterator_concept = std::forward_iterator_tag;
+      using iterator_category = std::input_iterator_tag;
+      using value_type = letter_result;
+      using difference_type = std::ptrdiff_t;
+
+      iterator() = default;
+
+      iterator(int const* first, int const* last)
+          : block_{first}
+          , position_{first}
+          , end_{last}
+      {
+        load();
+      }
+
+      auto operator*() const -> letter_result
+      {
+        if (valid_) {
+          return {letters_[std::size_t(position_ - block_)], violation::none};
+        }
+        return to_letter_result(*position_);
+      }
+
+      auto operator++() -> iterator&
+      {
+        ++position_;
+        if (position_ == block_ + block_size) {
+          block_ = position_;
+          load();
+        }
+        return *this;
+      }
+
+      auto operator++(int) -> iterator
+      {
+        auto previous{*this};
+        ++*this;
+        return previous;
+      }
+
+      friend auto operator==(iterator const& lhs, iterator const& rhs) -> bool
+      {
+        return lhs.position_ == rhs.position_;
+      }
+
+    private:
+      static constexpr std::size_t block_size{64};
+
+      void load()
+      {
+        auto const block{std::span{block_, std::min(block_size, std::size_t(end_ - block_))}};
+        valid_ = !block.empty() && find_invalid_position(block) == block.size();
+        if (valid_) {
+          positions_to_letters(block, std::span{letters_}.first(block.size()));
+        }
+      }
+
+      int const* block_{nullptr};
+      int const* position_{nullptr};
+      int const* end_{nullptr};
+      std::array<char, block_size> letters_{};
+      bool valid_{false};
+    };
+
+    blocked_letter_view() = default;
+
+    explicit blocked_letter_view(V base)
+        : base_{std::move(base)}
+    {
+    }
+
+    [[nodiscard]] auto begin() const
+    {
+      auto const* const first{std::ranges::data(base_)};
+      return iterator{first, first + std::ranges::size(base_)};
+    }
+
+    [[nodiscard]] auto end() const
+    {
+      auto const* const last{std::ranges::data(base_) + std::ranges::size(base_)};
+      return iterator{last, last};
+    }
+
+    [[nodiscard]] auto size() const
+    {
+      return std::ranges::size(base_);
+    }
+
+  private:
+    V base_{};
+  };
+
+  /// @brief The positions written in a range of characters, sanitized one token at a time.
+  /// @note Tokens are separated by whitespace and follow the syntax of batch mode,
+  ///       so a run, e.g. "5x3", yields a position once for each letter it denotes.
+  ///       An invalid token yields one position holding the violation.
+  /// @note When the characters are contiguous, each token is sanitized where it lies;
+  ///       otherwise it is first copied out of the range.
+  template<std::ranges::view V>
+  requires std::ranges::input_range<V> && std::same_as<std::ranges::range_value_t<V>, char>
+  class parse_positions_view : public std::ranges::view_interface<parse_positions_view<V>> {
+    static constexpr bool is_forward{std::ranges::forward_range<V>};
+    static constexpr bool is_contiguous{
+        std::ranges::contiguous_range<V> && std::sized_sentinel_for<std::ranges::sentinel_t<V>, std::ranges::iterator_t<V>>};
+
+  public:
+    class iterator {
+    public:
+      using iterator_concept = std::conditional_t<is_forward, std::forward_iterator_tag, std::input_iterator_tag>;
+      using iterator_category = std::input_iterator_tag;
+      using value_type = parsed_position;
+      using difference_type = std::ptrdiff_t;
+
+      iterator() = default;
+
+      iterator(std::ranges::iterator_t<V> first, std::ranges::sentinel_t<V> last)
+          : next_{std::move(first)}
+          , end_{std::move(last)}
+      {
+        parse();
+      }
+
+      auto operator*() const -> parsed_position
+      {
+        return current_;
+      }
+
+      auto operator++() -> iterator&
+      {
+        if (--remaining_ == 0) {
+          parse();
+        }
+        return *this;
+      }
+
+      auto operator++(int)
+      {
+        if constexpr (is_forward) {
+          auto previous{*this};
+          ++*this;
+          return previous;
+        }
+        else {
+          ++*this;
+        }
+      }
+
+      friend auto operator==(iterator const& lhs, iterator const& rhs) -> bool
+      requires is_forward
+      {
+        return lhs.next_ == rhs.next_ && lhs.remaining_ == rhs.remaining_;
+      }
+
+      friend auto operator==(iterator const& it, std::default_sentinel_t) -> bool
+      {
+        return it.remaining_ == 0;
+      }
+
+    private:
+      static constexpr auto is_whitespace(char c)
+      {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+      }
+
+      /// @brief read the next token, if there is one
+      void parse()
+      {
+        next_ = std::ranges::find_if_not(std::move(next_), end_, is_whitespace);
+        if (next_ == end_) {
+          return;
+        }
+
+        if constexpr (is_contiguous) {
+          auto const rest{std::string_view{std::to_address(next_), std::size_t(end_ - next_)}};
+          auto const token{rest.substr(0, std::min(rest.find_first_of(" \t\r\n"), rest.size()))};
+          next_ += std::ranges::range_difference_t<V>(token.size());
+          set(sanitize_token(token));
+        }
+        else {
+          std::string token;
+          for (; next_ != end_ && !is_whitespace(*next_); ++next_) {
+            token.push_back(*next_);
+          }
+          set(sanitize_token(token));
+        }
+      }
+
+      void set(sanitized_token const& result)
+      {
+        if (result.error == violation::none) {
+          current_ = {*result.number, violation::none};
+          remaining_ = result.letters.length;
+        }
+        else {
+          current_ = {result.number.value_or(0), result.error};
+          remaining_ = 1;
+        }
+      }
+
+      std::ranges::iterator_t<V> next_{};
+      std::ranges::sentinel_t<V> end_{};
+      parsed_position current_;
+
+      /// the number of times `current_` is yet to be yielded, including this one
+      std::size_t remaining_{0};
+    };
+
+    parse_positions_view() = default;
+
+    explicit parse_positions_view(V base)
+        : base_{std::move(base)}
+    {
+    }
+
+    [[nodiscard]] auto begin()
+    {
+      return iterator{std::ranges::begin(base_), std::ranges::end(base_)};
+    }
+
+    [[nodiscard]] auto end() const
+    {
+      return std::default_sentinel;
+    }
+
+  private:
+    V base_{};
+  };
+
+  /// @brief the type of `views::to_letter`
+  struct to_letter_fn {
+    template<std::ranges::viewable_range R>
+    auto operator()(R&& range) const
+    {
+      using view = std::views::all_t<R>;
+      if constexpr (
+          std::ranges::contiguous_range<view const> && std::ranges::sized_range<view const>
+          && std::same_as<std::ranges::range_value_t<view>, int>) {
+        return blocked_letter_view<view>{std::views::all(std::forward<R>(range))};
+      }
+      else {
+        return std::views::transform(std::forward<R>(range), [](auto const& position) {
+          return to_letter_result(position);
+        });
+      }
+    }
+
+    template<std::ranges::viewable_range R>
+    friend auto operator|(R&& range, to_letter_fn const& adaptor)
+    {
+      return adaptor(std::forward<R>(range));
+    }
+  };
+
+  /// @brief the type of `views::parse_positions`
+  struct parse_positions_fn {
+    template<std::ranges::viewable_range R>
+    auto operator()(R&& range) const
+    {
+      return parse_positions_view<std::views::all_t<R>>{std::views::all(std::forward<R>(range))};
+    }
+
+    template<std::ranges::viewable_range R>
+    friend auto operator|(R&& range, parse_positions_fn const& adaptor)
+    {
+      return adaptor(std::forward<R>(range));
+    }
+  };
+
+  /// @brief Sanitize and convert each position of a range, yielding a `letter_result` for each.
+  /// @note The range may hold `int` or `parsed_position` elements.
+  inline constexpr to_letter_fn to_letter{};
+
+  /// @brief Sanitize the positions written in a range of characters, yielding a `parsed_position` for each.
+  inline constexpr parse_positions_fn parse_positions{};
+}
+
+#endif  // EG_VIEWS_H
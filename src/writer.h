@@ -0,0 +1,147 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file A buffered output stream for the modes which write a lot of text.
+
+#if !defined(EG_WRITER_H)
+#define EG_WRITER_H
+
+#include "eg_assert.h"
+#include "log_queue.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+/// @brief A buffered sink for bulk output
+/// @note Pass `std::back_inserter(w)` to `fmt::format_to` to print formatted text.
+/// @note A failure to write is sticky and is reported by `flush`
+///       so that callers can check once, rather than after every write.
+class writer {
+public:
+  using value_type = char;
+
+  static constexpr std::size_t default_capacity{std::size_t{1} << 16U};
+
+  /// @pre file is open for writing
+  /// @pre capacity is not zero
+  explicit writer(std::FILE* file, std::size_t capacity = default_capacity)
+      : file_{file}
+      , buffer_(capacity)
+  {
+    eg_assert(file != nullptr);
+    eg_assert(capacity != 0);
+  }
+
+  /// @brief a sink which hands its bytes to a background thread instead of writing them itself
+  /// @pre capacity is not zero
+  explicit writer(log_queue& queue, std::size_t capacity = default_capacity)
+      : file_{queue.file()}
+      , queue_{&queue}
+      , buffer_(capacity)
+  {
+    eg_assert(capacity != 0);
+  }
+
+  writer(writer const&) = delete;
+  writer(writer&&) = delete;
+  auto operator=(writer const&) -> writer& = delete;
+  auto operator=(writer&&) -> writer& = delete;
+
+  ~writer()
+  {
+    drain();
+  }
+
+  void push_back(char c)
+  {
+    if (size_ == buffer_.size()) {
+      drain();
+    }
+    buffer_[size_++] = c;
+  }
+
+  void write(std::string_view text)
+  {
+    while (!text.empty()) {
+      if (size_ == buffer_.size()) {
+        drain();
+      }
+      auto const n{std::min(text.size(), buffer_.size() - size_)};
+      std::memcpy(buffer_.data() + size_, text.data(), n);
+      size_ += n;
+      text.remove_prefix(n);
+    }
+  }
+
+  /// @brief write `count` copies of `c` using wide stores
+  void fill(char c, std::size_t count)
+  {
+    while (count != 0) {
+      if (size_ == buffer_.size()) {
+        drain();
+      }
+      auto const n{std::min(count, buffer_.size() - size_)};
+      std::memset(buffer_.data() + size_, c, n);
+      size_ += n;
+      count -= n;
+    }
+  }
+
+  /// @return the number of bytes written so far, including those still buffered
+  [[nodiscard]] auto offset() const
+  {
+    return drained_ + size_;
+  }
+
+  /// @return the file to which bytes are written
+  [[nodiscard]] auto file() const
+  {
+    return file_;
+  }
+
+  /// @brief write any buffered bytes to the file
+  /// @return true iff every write so far has succeeded
+  auto flush() -> bool
+  {
+    drain();
+    if (queue_ != nullptr) {
+      return queue_->flush() && !failed_;
+    }
+    return !failed_ && std::fflush(file_) == 0;
+  }
+
+private:
+  void drain()
+  {
+    if (size_ != 0 && !failed_) {
+      failed_ = queue_ != nullptr ? !queue_->push({buffer_.data(), size_})
+                                  : std::fwrite(buffer_.data(), 1, size_, file_) != size_;
+    }
+    drained_ += size_;
+    size_ = 0;
+  }
+
+  std::FILE* file_;
+  log_queue* queue_{nullptr};
+  std::vector<char> buffer_;
+  std::size_t size_{0};
+  std::uint64_t drained_{0};
+  bool failed_{false};
+};
+
+#endif  // EG_WRITER_H
@@ -0,0 +1,43 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: index a batch run and look up the output and diagnostics of one line of input
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+for _ in $(seq 3000); do echo '1 27'; done > "${WORK_DIR}/input.txt"
+
+set +e
+"${BUILD_DIR}/src/example-program" --batch "${WORK_DIR}/input.txt" \
+    --output "${WORK_DIR}/output.txt" \
+    --error-log "${WORK_DIR}/errors.txt" \
+    --index "${WORK_DIR}/index.bin"
+set -e
+
+EXPECTED="A
+2026:3: Out-of-range number, 27"
+
+set +e
+ACTUAL=$("${BUILD_DIR}/src/example-program" --batch \
+    --output "${WORK_DIR}/output.txt" \
+    --error-log "${WORK_DIR}/errors.txt" \
+    --index "${WORK_DIR}/index.bin" \
+    --lookup 2026 2>&1)
+EXIT_CODE=$?
+set -e
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+if [ "1" != "$EXIT_CODE" ]; then
+    echo "FAIL: Exit code is $EXIT_CODE"
+    exit 1
+fi
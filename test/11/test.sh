@@ -0,0 +1,36 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: look up a line beyond the end of an indexed batch run and get back an error message
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+printf '1\n2\n3\n' | "${BUILD_DIR}/src/example-program" --batch \
+    --output "${WORK_DIR}/output.txt" \
+    --index "${WORK_DIR}/index.bin"
+
+EXPECTED="Out-of-range line number, 4"
+
+set +e
+ACTUAL=$("${BUILD_DIR}/src/example-program" --batch \
+    --output "${WORK_DIR}/output.txt" \
+    --index "${WORK_DIR}/index.bin" \
+    --lookup 4 2>&1 >/dev/null)
+EXIT_CODE=$?
+set -e
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+if [ "1" != "$EXIT_CODE" ]; then
+    echo "FAIL: Exit code is $EXIT_CODE"
+    exit 1
+fi
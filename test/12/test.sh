@@ -0,0 +1,23 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass NDJSON records in batch mode and get back NDJSON letters and errors
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED='{"n":3,"letter":"C"}
+{"n":"1X","error":"unrecognized"}
+{"n":27,"error":"out-of-range"}'
+
+set +e
+ACTUAL=$(printf '{"n":3}\n{"id":"x","n":"1X"}\n{"a":{"n":5},"n":27}\n' | "${BUILD_DIR}/src/example-program" --batch --format=ndjson 2>/dev/null)
+set -e
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
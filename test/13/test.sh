@@ -0,0 +1,28 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass bad NDJSON records in batch mode and get back located error messages
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="1:9: Out-of-range number, 0
+2:1: Missing field, 'pos'"
+
+set +e
+ACTUAL=$(printf '{"pos": 0 }\n{"n":1}\n' | "${BUILD_DIR}/src/example-program" --batch --format ndjson --field pos 2>&1 >/dev/null)
+EXIT_CODE=$?
+set -e
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+if [ "1" != "$EXIT_CODE" ]; then
+    echo "FAIL: Exit code is $EXIT_CODE"
+    exit 1
+fi
@@ -0,0 +1,21 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass CSV records in batch mode and get back the same records with one column converted
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED='name,position,note
+alice,C,"a, b"
+bob,Z,"two
+lines"'
+ACTUAL=$(printf 'name,position,note\nalice,3,"a, b"\nbob,"26","two\nlines"\n' | "${BUILD_DIR}/src/example-program" --batch --csv-column 2 --csv-header)
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
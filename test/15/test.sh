@@ -0,0 +1,28 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass bad CSV records in batch mode and get back located error messages
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="1:9: Out-of-range number, 27
+2:1: Missing column, 3"
+
+set +e
+ACTUAL=$(printf '"a,b",x,27\nc\n' | "${BUILD_DIR}/src/example-program" --batch --csv-column=3 2>&1 >/dev/null)
+EXIT_CODE=$?
+set -e
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+if [ "1" != "$EXIT_CODE" ]; then
+    echo "FAIL: Exit code is $EXIT_CODE"
+    exit 1
+fi
@@ -0,0 +1,21 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass gzip-compressed input, made of two members, in batch mode and get back letters
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="HELLO
+CCCCC
+WORLD"
+
+ACTUAL=$( (printf '8 5 12 12 15\n5x3\n' | gzip; printf '23 15 18 12 4\n' | gzip) | "${BUILD_DIR}/src/example-program" --batch --threads 2)
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
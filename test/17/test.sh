@@ -0,0 +1,32 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass truncated gzip-compressed input in batch mode and get back an error message
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+seq 1 26 | gzip > "${WORK_DIR}/input.gz"
+truncate --size=20 "${WORK_DIR}/input.gz"
+
+EXPECTED="Failed to read input: truncated gzip data"
+
+set +e
+ACTUAL=$("${BUILD_DIR}/src/example-program" --batch "${WORK_DIR}/input.gz" 2>&1 >/dev/null)
+EXIT_CODE=$?
+set -e
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+if [ "1" != "$EXIT_CODE" ]; then
+    echo "FAIL: Exit code is $EXIT_CODE"
+    exit 1
+fi
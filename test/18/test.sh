@@ -0,0 +1,46 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass positions in batch mode and get back how many times each letter occurred
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="A 1
+B 0
+C 5
+D 0
+E 1
+F 0
+G 0
+H 1
+I 0
+J 0
+K 0
+L 2
+M 0
+N 0
+O 1
+P 0
+Q 0
+R 0
+S 0
+T 0
+U 0
+V 0
+W 0
+X 0
+Y 0
+Z 1
+unrecognized 0
+out-of-range 0"
+
+ACTUAL=$(printf '8 5 12 12 15\n5x3\n\n26 1\n' | "${BUILD_DIR}/src/example-program" --batch --histogram --threads 2)
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,28 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass bad positions in histogram batch mode and get back located error messages
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="1:3: Out-of-range number, 27
+3:1: Unrecognized number, 'X'"
+
+set +e
+ACTUAL=$(printf '1 27\n2\nX 3\n' | "${BUILD_DIR}/src/example-program" --batch --histogram --threads 2 2>&1 >/dev/null)
+EXIT_CODE=$?
+set -e
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+if [ "1" != "$EXIT_CODE" ]; then
+    echo "FAIL: Exit code is $EXIT_CODE"
+    exit 1
+fi
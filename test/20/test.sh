@@ -0,0 +1,24 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: compose range adaptors which parse and convert positions in C++ code
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="vector: HELLO??WORLD
+list: HELLO??WORLD
+text: HELLOCC???
+characters: HELLOCC???
+composed: HELLO
+many: 199 of 200 valid, ending R"
+
+ACTUAL=$("${BUILD_DIR}/test/views-example")
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
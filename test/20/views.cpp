@@ -0,0 +1,74 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file An example of C++ code composing the conversion of positions into its own range pipelines.
+
+#include "views.h"
+
+#include <list>
+#include <numeric>
+#include <ranges>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace {
+  /// @brief print a range of results as letters, with a '?' in place of each violation
+  void print(std::string_view name, std::ranges::input_range auto&& letters)
+  {
+    fmt::print("{}: ", name);
+    for (letter_result const result : letters) {
+      fmt::print("{}", result.error == violation::none ? result.letter : '?');
+    }
+    fmt::print("\n");
+  }
+}
+
+auto main() -> int
+{
+  using namespace std::literals::string_view_literals;
+
+  // Contiguous positions are converted in blocks.
+  auto const positions{std::vector{8, 5, 12, 12, 15, 27, 0, 23, 15, 18, 12, 4}};
+  print("vector", positions | views::to_letter);
+
+  // Other ranges are converted one position at a time.
+  auto const list{std::list<int>(positions.begin(), positions.end())};
+  print("list", list | views::to_letter);
+
+  // Positions can be parsed straight from text.
+  auto const text{"8 5 12 12 15 2x3 X 27 99999999999"sv};
+  print("text", text | views::parse_positions | views::to_letter);
+
+  auto const characters{std::list<char>(text.begin(), text.end())};
+  print("characters", characters | views::parse_positions | views::to_letter);
+
+  // The results compose with the standard views.
+  print(
+      "composed",
+      positions | views::to_letter | std::views::filter([](letter_result r) { return r.error == violation::none; })
+          | std::views::take(5));
+
+  // Blocks which hold an invalid position fall back to one position at a time.
+  std::vector<int> many(200);
+  std::iota(many.begin(), many.end(), 0);
+  for (auto& position : many) {
+    position = position % 26 + 1;
+  }
+  many[100] = 0;
+  auto const results{many | views::to_letter};
+  auto const num_valid{std::ranges::count(results, violation::none, &letter_result::error)};
+  fmt::print("many: {} of {} valid, ending {}\n", num_valid, results.size(), (*std::ranges::next(results.begin(), 199)).letter);
+}
@@ -0,0 +1,56 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file An example of C++ code converting a large number of positions on several threads.
+
+#include "bulk.h"
+
+#include <execution>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+auto main() -> int
+{
+  constexpr std::size_t num_positions{3'000'017};
+  constexpr std::size_t invalid_index{2'222'221};
+
+  std::vector<int> positions(num_positions);
+  for (std::size_t i{0}; i != positions.size(); ++i) {
+    positions[i] = int(i % 26) + 1;
+  }
+
+  // Sanitize.
+  positions[invalid_index] = 27;
+  fmt::print("seq: {}\n", find_invalid_position(std::execution::seq, positions));
+  fmt::print("par: {}\n", find_invalid_position(std::execution::par, positions));
+  fmt::print("par_unseq: {}\n", find_invalid_position(std::execution::par_unseq, positions));
+  fmt::print("4 threads: {}\n", find_invalid_position(positions, 4));
+  positions[invalid_index] = 1;
+  fmt::print("valid: {}\n", find_invalid_position(positions, 4) == positions.size());
+
+  // Convert.
+  std::vector<char> sequential(num_positions);
+  positions_to_letters(std::execution::seq, positions, sequential);
+  std::vector<char> parallel(num_positions);
+  positions_to_letters(std::execution::par, positions, parallel);
+  std::vector<char> threaded(num_positions);
+  positions_to_letters(positions, threaded, 7);
+  fmt::print(
+      "letters: {}...{}, {}\n",
+      std::string_view{sequential.data(), 5},
+      std::string_view{sequential.data() + num_positions - 5, 5},
+      sequential == parallel && sequential == threaded ? "same" : "different");
+}
@@ -0,0 +1,24 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: sanitize and convert many positions in C++ code under parallel execution policies
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="seq: 2222221
+par: 2222221
+par_unseq: 2222221
+4 threads: 2222221
+valid: true
+letters: ABCDE...CDEFG, same"
+
+ACTUAL=$("${BUILD_DIR}/test/bulk-example")
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,83 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file An example of C++ code consuming the results of bulk conversion as a structure of arrays.
+
+#include "bulk.h"
+
+#include <algorithm>
+#include <bit>
+#include <execution>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace {
+  /// @brief print the lanes of a batch
+  void print(std::string_view name, letter_batch const& batch)
+  {
+    fmt::print("{}: {} of {} failed\n", name, batch.num_failures(), batch.size());
+
+    // The letters are contiguous and can be written as they are.
+    std::string letters{batch.letters().begin(), batch.letters().end()};
+    std::replace(letters.begin(), letters.end(), '\0', '.');
+    fmt::print("  letters: {}\n", letters);
+
+    // The failures can be found by scanning the bitmap.
+    fmt::print("  failures:");
+    for (std::size_t word{0}; word != batch.failures().size(); ++word) {
+      for (auto bits{batch.failures()[word]}; bits != 0; bits &= bits - 1) {
+        auto const index{word * letter_batch::bits_per_word + std::size_t(std::countr_zero(bits))};
+        fmt::print(" {}={}", index, violation_name(batch.errors()[index]));
+      }
+    }
+    fmt::print("\n");
+  }
+}
+
+auto main() -> int
+{
+  using namespace std::literals::string_view_literals;
+
+  letter_batch batch;
+  convert_positions(std::vector{8, 5, 12, 12, 15, 0, 23, 15, 18, 12, 4, 27}, batch);
+  print("positions", batch);
+
+  convert_text("8 5 12 12 15 X 2x3 99999999999 1"sv, batch);
+  print("text", batch);
+
+  // Large batches can be converted on several threads.
+  std::vector<int> positions(1'000'003);
+  for (std::size_t i{0}; i != positions.size(); ++i) {
+    positions[i] = int(i % 28);
+  }
+  letter_batch sequential;
+  convert_positions(std::execution::seq, positions, sequential);
+  letter_batch parallel;
+  convert_positions(std::execution::par, positions, parallel);
+  letter_batch threaded;
+  convert_positions(positions, threaded, 5);
+  auto const same = [&](letter_batch const& other) {
+    return std::ranges::equal(sequential.letters(), other.letters())
+        && std::ranges::equal(sequential.errors(), other.errors())
+        && std::ranges::equal(sequential.failures(), other.failures());
+  };
+  fmt::print(
+      "many: {} of {} failed, {}\n",
+      sequential.num_failures(),
+      sequential.size(),
+      same(parallel) && same(threaded) ? "same" : "different");
+}
@@ -0,0 +1,25 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: convert positions in C++ code and get back letters, error codes and a failure bitmap
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="positions: 2 of 12 failed
+  letters: HELLO.WORLD.
+  failures: 5=out-of-range 11=out-of-range
+text: 2 of 10 failed
+  letters: HELLO.CC.A
+  failures: 5=unrecognized 8=out-of-range
+many: 71429 of 1000003 failed, same"
+
+ACTUAL=$("${BUILD_DIR}/test/batch-example")
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
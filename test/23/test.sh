@@ -0,0 +1,19 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass trusted binary positions in batch mode and get back letters
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="HELLOWORLD"
+
+ACTUAL=$(printf '\x08\x05\x0c\x0c\x0f\x17\x0f\x12\x0c\x04' | "${BUILD_DIR}/src/example-program" --batch --format=binary --trusted)
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,28 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass binary positions which break the trusted guarantee and get back located error messages
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="1:3: Out-of-range number, 0
+1:5: Out-of-range number, 27"
+
+set +e
+ACTUAL=$(printf '\x08\x05\x00\x0c\x1b' | "${BUILD_DIR}/src/example-program" --batch --format=binary --trusted 2>&1 >/dev/null)
+EXIT_CODE=$?
+set -e
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+if [ "1" != "$EXIT_CODE" ]; then
+    echo "FAIL: Exit code is $EXIT_CODE"
+    exit 1
+fi
@@ -0,0 +1,27 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass text holding control characters and invalid UTF-8 and get back an escaped error message
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="Unrecognized number, 'A\x1b[2J\'\\\\é\xff\u202e'"
+
+set +e
+ACTUAL=$("${BUILD_DIR}/src/example-program" "$(printf 'A\x1b[2J'"'"'\\\xc3\xa9\xff\xe2\x80\xae')" 2>&1 >/dev/null)
+EXIT_CODE=$?
+set -e
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+if [ "1" != "$EXIT_CODE" ]; then
+    echo "FAIL: Exit code is $EXIT_CODE"
+    exit 1
+fi
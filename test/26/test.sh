@@ -0,0 +1,27 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass a very long bad token in batch mode and get back a truncated error message
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="1:3: Unrecognized number, 'XXXXXXXX'... (100000 bytes)"
+
+set +e
+ACTUAL=$(printf '1 %s\n' "$(printf 'X%.0s' $(seq 100000))" | "${BUILD_DIR}/src/example-program" --batch --echo-limit 8 2>&1 >/dev/null)
+EXIT_CODE=$?
+set -e
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+if [ "1" != "$EXIT_CODE" ]; then
+    echo "FAIL: Exit code is $EXIT_CODE"
+    exit 1
+fi
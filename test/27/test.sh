@@ -0,0 +1,54 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: run batch mode twice with a cache directory and get back the same results both times,
+# the second time from the cache
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+printf '8 5 12 12 15\n1X 3\n' > "${WORK_DIR}/input.txt"
+
+EXPECTED="HELLO
+C
+2:1: Unrecognized number, '1X'
+exit code 1"
+
+run() {
+    set +e
+    "${BUILD_DIR}/src/example-program" --batch --cache "${WORK_DIR}/cache" "${WORK_DIR}/input.txt" 2>&1
+    echo "exit code $?"
+    set -e
+}
+
+for RUN in miss hit; do
+    ACTUAL=$(run)
+    if [ "$EXPECTED" = "$ACTUAL" ]; then
+        echo "PASS: Strings are equal on cache ${RUN}."
+    else
+        echo "FAIL: Strings are not equal on cache ${RUN}."
+        echo "Expected: $EXPECTED"
+        echo "Actual: $ACTUAL"
+        exit 1
+    fi
+done
+
+# The output of the second run came from the cache, so a change to the cache shows through.
+for OUTPUT in "${WORK_DIR}"/cache/*.out; do
+    printf 'CACHED\n' > "${OUTPUT}"
+done
+
+EXPECTED="CACHED
+2:1: Unrecognized number, '1X'
+exit code 1"
+
+ACTUAL=$(run)
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
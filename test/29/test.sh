@@ -0,0 +1,58 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: change one line of a large input converted with a cache directory
+# and get back the same results as without the cache, having converted only a few chunks of it again,
+# then run it again and get back the same results from the entry for the whole input
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+awk 'BEGIN { srand(1); for (i = 0; i != 100000; ++i) print int(rand() * 28), int(rand() * 28) }' > "${WORK_DIR}/before.txt"
+sed '50000s/.*/1X 2/' "${WORK_DIR}/before.txt" > "${WORK_DIR}/after.txt"
+
+set +e
+"${BUILD_DIR}/src/example-program" --batch --cache "${WORK_DIR}/cache" "${WORK_DIR}/before.txt" > "${WORK_DIR}/before.out" 2>&1
+BEFORE_ENTRIES=$(ls "${WORK_DIR}"/cache/*.outcome | wc -l)
+BEFORE_BYTES=$(wc -c < "${WORK_DIR}/before.out")
+STORED_BYTES=$(cat "${WORK_DIR}"/cache/*.out "${WORK_DIR}"/cache/*.err | wc -c)
+EXPECTED=$("${BUILD_DIR}/src/example-program" --batch "${WORK_DIR}/after.txt" 2>"${WORK_DIR}/expected.err"; echo "exit code $?")
+ACTUAL=$("${BUILD_DIR}/src/example-program" --batch --cache "${WORK_DIR}/cache" "${WORK_DIR}/after.txt" 2>"${WORK_DIR}/actual.err"; echo "exit code $?")
+EXPECTED+=$(cat "${WORK_DIR}/expected.err")
+ACTUAL+=$(cat "${WORK_DIR}/actual.err")
+NEW_ENTRIES=$(( $(ls "${WORK_DIR}"/cache/*.outcome | wc -l) - BEFORE_ENTRIES ))
+AFTER_ENTRIES=$(ls "${WORK_DIR}"/cache/*.outcome | wc -l)
+EXPECTED+="${EXPECTED}"
+ACTUAL+=$("${BUILD_DIR}/src/example-program" --batch --cache "${WORK_DIR}/cache" "${WORK_DIR}/after.txt" 2>"${WORK_DIR}/rerun.err"; echo "exit code $?")
+ACTUAL+=$(cat "${WORK_DIR}/rerun.err")
+set -e
+RERUN_ENTRIES=$(( $(ls "${WORK_DIR}"/cache/*.outcome | wc -l) - AFTER_ENTRIES ))
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+# Besides the entry for the whole input, only the one or two chunks around the changed line are new.
+if [ "$BEFORE_ENTRIES" -lt 3 ] || [ "$NEW_ENTRIES" -gt 3 ]; then
+    echo "FAIL: ${NEW_ENTRIES} of ${BEFORE_ENTRIES} entries are new"
+    exit 1
+fi
+
+# The identical rerun is served whole.
+if [ "$RERUN_ENTRIES" -ne 0 ]; then
+    echo "FAIL: ${RERUN_ENTRIES} entries are new on an identical rerun"
+    exit 1
+fi
+
+# The chunks and the whole input each hold a copy of the results,
+# with diagnostics shorter for being numbered from each chunk's first line.
+if [ "$STORED_BYTES" -gt $(( 2 * BEFORE_BYTES )) ]; then
+    echo "FAIL: ${STORED_BYTES} bytes are stored for ${BEFORE_BYTES} bytes of results"
+    exit 1
+fi
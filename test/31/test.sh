@@ -0,0 +1,56 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: kill a batch run with a checkpoint part of the way through, resume it,
+# and get back the same output, diagnostics and exit code as a run which was never stopped
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+printf '8 5\n1X\n12 12 15\n' > "${WORK_DIR}/input.txt"
+touch "${WORK_DIR}/output.txt"
+
+# Following the input is a way to stop part of the way through it.
+"${BUILD_DIR}/src/example-program" --batch --follow "${WORK_DIR}/input.txt" --output "${WORK_DIR}/output.txt" \
+    --error-log "${WORK_DIR}/errors.txt" --checkpoint "${WORK_DIR}/checkpoint.txt" &
+PID=$!
+for _ in $(seq 100); do
+    if [ "$(wc -l < "${WORK_DIR}/output.txt")" -ge 3 ]; then
+        break
+    fi
+    sleep 0.1
+done
+kill -KILL "${PID}"
+wait "${PID}" || true
+
+printf '23 15\n18 4\n' >> "${WORK_DIR}/input.txt"
+
+set +e
+"${BUILD_DIR}/src/example-program" --batch "${WORK_DIR}/input.txt" --output "${WORK_DIR}/output.txt" \
+    --error-log "${WORK_DIR}/errors.txt" --checkpoint "${WORK_DIR}/checkpoint.txt" --resume
+EXIT_CODE=$?
+set -e
+
+EXPECTED="HE
+
+LLO
+WO
+RD
+2:1: Unrecognized number, '1X'"
+
+ACTUAL=$(cat "${WORK_DIR}/output.txt" "${WORK_DIR}/errors.txt")
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+if [ "1" != "$EXIT_CODE" ]; then
+    echo "FAIL: Exit code is $EXIT_CODE"
+    exit 1
+fi
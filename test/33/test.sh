@@ -0,0 +1,37 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: convert an input in three shards and get back, concatenated, the output and diagnostics of one run
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+printf '8 5\n1X\n12 12 15\n23 15\n27\n18 4' > "${WORK_DIR}/input.txt"
+
+set +e
+for SHARD in 1/3 2/3 3/3; do
+    "${BUILD_DIR}/src/example-program" --batch --shard "${SHARD}" "${WORK_DIR}/input.txt" \
+        >> "${WORK_DIR}/output.txt" 2>> "${WORK_DIR}/errors.txt"
+done
+set -e
+
+EXPECTED="HE
+
+LLO
+WO
+
+RD
+2:1: Unrecognized number, '1X'
+5:1: Out-of-range number, 27"
+
+ACTUAL=$(cat "${WORK_DIR}/output.txt" "${WORK_DIR}/errors.txt")
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,34 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass a shard beyond the number of shards in batch mode, or a shard with --on-error=stop,
+# whose shards would not add up to a single run, and get back error messages
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="Out-of-range shard, '4/3'
+Option --shard cannot be combined with options --format=binary, --csv-column, --histogram, --index, \
+--cache, --follow, --checkpoint or --on-error=stop
+exit code 1"
+
+set +e
+ACTUAL=$("${BUILD_DIR}/src/example-program" --batch --shard 4/3 /dev/null 2>&1 >/dev/null)
+EXIT_CODE=$?
+ACTUAL+="
+$("${BUILD_DIR}/src/example-program" --batch --shard 1/2 --on-error=stop /dev/null 2>&1 >/dev/null)
+exit code $?"
+set -e
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+if [ "1" != "$EXIT_CODE" ]; then
+    echo "FAIL: Exit code is $EXIT_CODE"
+    exit 1
+fi
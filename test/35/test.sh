@@ -0,0 +1,36 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: calibrate batch mode, then convert with the saved tuning and get back the usual output
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+# Which values are chosen depends on the machine; only the names are compared.
+EXPECTED="threads
+chunk-size
+buffer-size
+parallel-threshold
+threads
+chunk-size
+buffer-size
+parallel-threshold
+HELLO"
+
+ACTUAL=$(
+    "${BUILD_DIR}/src/example-program" --batch --calibrate --threads 2 --tuning "${WORK_DIR}/tuning/file" | cut -d' ' -f1
+    cut -d' ' -f1 "${WORK_DIR}/tuning/file"
+    printf '8 5 12 12 15\n' | "${BUILD_DIR}/src/example-program" --batch --histogram --tuning "${WORK_DIR}/tuning/file" \
+        > /dev/null
+    printf '8 5 12 12 15\n' | "${BUILD_DIR}/src/example-program" --batch --tuning "${WORK_DIR}/tuning/file"
+)
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
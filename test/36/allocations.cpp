@@ -0,0 +1,167 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file A library which counts heap allocations, for preloading into the program under test.
+/// @note `operator new` and the `malloc` family are interposed, and each counts once per allocation.
+///       On exit, the count and the peak resident set size are written to the file named by
+///       `EG_ALLOCATION_REPORT`, as `name value` lines.
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <sys/resource.h>
+
+// glibc's own allocator, which the interposed functions forward to.
+extern "C" {
+auto __libc_malloc(std::size_t size) -> void*;
+auto __libc_calloc(std::size_t count, std::size_t size) -> void*;
+auto __libc_realloc(void* pointer, std::size_t size) -> void*;
+auto __libc_memalign(std::size_t alignment, std::size_t size) -> void*;
+}
+
+namespace {
+  std::atomic<unsigned long long> num_allocations{0};
+
+  auto count(void* pointer)
+  {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    return pointer;
+  }
+
+  auto allocate(std::size_t size)
+  {
+    auto* const pointer{count(__libc_malloc(size == 0 ? 1 : size))};
+    if (pointer == nullptr) {
+      throw std::bad_alloc{};
+    }
+    return pointer;
+  }
+
+  auto allocate(std::size_t size, std::align_val_t alignment)
+  {
+    auto* const pointer{count(__libc_memalign(std::size_t(alignment), size == 0 ? 1 : size))};
+    if (pointer == nullptr) {
+      throw std::bad_alloc{};
+    }
+    return pointer;
+  }
+
+  [[gnu::destructor]] void report()
+  {
+    auto const* const path{std::getenv("EG_ALLOCATION_REPORT")};
+    if (path == nullptr) {
+      return;
+    }
+    auto* const file{std::fopen(path, "w")};
+    if (file == nullptr) {
+      return;
+    }
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    std::fprintf(file, "allocations %llu\npeak-rss-kib %ld\n", num_allocations.load(), usage.ru_maxrss);
+    std::fclose(file);
+  }
+}
+
+extern "C" {
+auto malloc(std::size_t size) -> void*
+{
+  return count(__libc_malloc(size));
+}
+
+auto calloc(std::size_t num, std::size_t size) -> void*
+{
+  return count(__libc_calloc(num, size));
+}
+
+auto realloc(void* pointer, std::size_t size) -> void*
+{
+  return count(__libc_realloc(pointer, size));
+}
+
+auto aligned_alloc(std::size_t alignment, std::size_t size) -> void*
+{
+  return count(__libc_memalign(alignment, size));
+}
+
+auto posix_memalign(void** pointer, std::size_t alignment, std::size_t size) -> int
+{
+  *pointer = count(__libc_memalign(alignment, size));
+  return *pointer != nullptr ? 0 : ENOMEM;
+}
+}
+
+auto operator new(std::size_t size) -> void*
+{
+  return allocate(size);
+}
+
+auto operator new[](std::size_t size) -> void*
+{
+  return allocate(size);
+}
+
+auto operator new(std::size_t size, std::align_val_t alignment) -> void*
+{
+  return allocate(size, alignment);
+}
+
+auto operator new[](std::size_t size, std::align_val_t alignment) -> void*
+{
+  return allocate(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::align_val_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept
+{
+  std::free(pointer);
+}
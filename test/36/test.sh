@@ -0,0 +1,81 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: convert a small and a large input in each mode and make no more heap allocations for the large one,
+# including inputs with a line too long to hold, of which only the first 16 MiB are kept
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+# Small buffers, so that even the small input is past the first few of them and in the steady state
+printf 'threads 2\nchunk-size 4096\nbuffer-size 4096\nparallel-threshold 4096\n' > "${WORK_DIR}/tuning"
+
+# Good tokens, with bad ones long enough that echoing them could allocate
+generate() {
+    awk -v lines="$1" -v format="$2" 'BEGIN {
+        srand(1)
+        for (i = 0; i < lines; ++i) {
+            r = int(rand() * 10)
+            if (r == 0) token = sprintf("%0100dX\033", i)
+            else if (r == 1) token = "99999999999999999999999999999999999999999999999999999999999999999999999999999"
+            else token = sprintf("%dx%d", 1 + int(rand() * 3), 1 + int(rand() * 26))
+            if (format == "ndjson") printf "{\"n\":\"%s\"}\n", token
+            else if (format == "csv") printf "%d,%s,\"a, b\"\n", i, token
+            else printf "%d %s %d\n", 1 + int(rand() * 26), token, 1 + int(rand() * 26)
+        }
+    }'
+}
+
+for format in text ndjson csv; do
+    generate 2000 ${format} > "${WORK_DIR}/small.${format}"
+    generate 32000 ${format} > "${WORK_DIR}/large.${format}"
+done
+gzip -k "${WORK_DIR}/small.text" "${WORK_DIR}/large.text"
+
+# A good line, a line of `bytes` bytes and another good line
+long_line() {
+    printf '8 5\n'
+    head -c "$1" /dev/zero | tr '\0' 7
+    printf '\n8 5\n'
+}
+long_line 20000000 > "${WORK_DIR}/small.long"
+long_line 80000000 > "${WORK_DIR}/large.long"
+
+# Print the allocations made converting the `size` input of `extension` with the remaining arguments.
+allocations() {
+    local size=$1 extension=$2
+    shift 2
+    EG_ALLOCATION_REPORT="${WORK_DIR}/report" LD_PRELOAD="${BUILD_DIR}/test/liballocation-counter.so" \
+        "${BUILD_DIR}/src/example-program" --batch --tuning "${WORK_DIR}/tuning" "$@" "${WORK_DIR}/${size}.${extension}" \
+        > /dev/null 2> /dev/null || true
+    cat "${WORK_DIR}/report"
+}
+
+EXPECTED=""
+ACTUAL=""
+for mode in "text" "text --rle" "text --threads 2" "text --histogram --threads 2" "text.gz" \
+    "ndjson --format=ndjson" "ndjson --format=ndjson --histogram" "csv --csv-column 2" \
+    "long" "long --histogram --threads 2"; do
+    small=$(allocations small ${mode})
+    large=$(allocations large ${mode})
+    EXPECTED+="${mode}: $(head -1 <<< "${small}")"$'\n'
+    ACTUAL+="${mode}: $(head -1 <<< "${large}")"$'\n'
+    echo "${mode}: $(tail -1 <<< "${large}")"
+done
+
+# The long line is rejected and the lines after it are still converted.
+EXPECTED+="HE
+
+HE
+2:16777217: Line too long (at most 16777216 bytes)"
+ACTUAL+="$("${BUILD_DIR}/src/example-program" --batch --tuning "${WORK_DIR}/tuning" "${WORK_DIR}/large.long" 2>&1 || true)"
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,67 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: run the program many times at once with telemetry on, then dump the counters
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+export EG_TELEMETRY="${WORK_DIR}/telemetry"
+
+# Wall time varies, so only whether it was counted is compared.
+EXPECTED="invocations 24
+batch-invocations 1
+successes 21
+usage-errors 2
+input-errors 1
+wrong-number-of-arguments 1
+unrecognized-numbers 1
+out-of-range-numbers 0
+wall-time-ns counted
+A 0
+B 0
+C 0
+D 0
+E 0
+F 0
+G 0
+H 10
+I 0
+J 0
+K 0
+L 0
+M 0
+N 0
+O 0
+P 0
+Q 0
+R 0
+S 0
+T 0
+U 0
+V 0
+W 0
+X 0
+Y 0
+Z 10"
+
+for _ in $(seq 10); do
+    "${BUILD_DIR}/src/example-program" 8 > /dev/null &
+    "${BUILD_DIR}/src/example-program" 26 > /dev/null &
+done
+"${BUILD_DIR}/src/example-program" > /dev/null 2>&1 || true
+"${BUILD_DIR}/src/example-program" 1X > /dev/null 2>&1 || true
+printf '0\n' | "${BUILD_DIR}/src/example-program" --batch > /dev/null 2>&1 || true
+"${BUILD_DIR}/src/example-program" --help > /dev/null
+wait
+
+ACTUAL=$("${BUILD_DIR}/src/example-program" --telemetry-dump | sed 's/^wall-time-ns [1-9][0-9]*$/wall-time-ns counted/')
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
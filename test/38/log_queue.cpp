@@ -0,0 +1,91 @@
+// Copyright 2021 John McFarlane
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/// @file An example of C++ code logging from several threads at once through a queue.
+
+#include "log_queue.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace {
+  constexpr auto num_threads{4};
+  constexpr auto num_lines{10'000};
+
+  /// @return the lines written to `file`, from the start
+  auto read_lines(std::FILE* file)
+  {
+    std::rewind(file);
+    std::vector<std::string> lines;
+    std::array<char, 64> line{};
+    while (std::fgets(line.data(), int(line.size()), file) != nullptr) {
+      lines.emplace_back(line.data());
+    }
+    return lines;
+  }
+}
+
+auto main() -> int
+{
+  // Lines from several threads, with back-pressure, all arrive whole and in each thread's order.
+  {
+    auto* const file{std::tmpfile()};
+    {
+      log_queue queue{file, log_queue::overflow::wait, 16};
+      std::vector<std::jthread> threads;
+      for (auto thread{0}; thread != num_threads; ++thread) {
+        threads.emplace_back([&queue, thread] {
+          for (auto line{0}; line != num_lines; ++line) {
+            queue.push(fmt::format("{} {}\n", thread, line));
+          }
+        });
+      }
+    }
+
+    std::array<int, num_threads> next{};
+    auto in_order{true};
+    for (auto const& line : read_lines(file)) {
+      int thread{-1};
+      int number{-1};
+      in_order &= std::sscanf(line.c_str(), "%d %d\n", &thread, &number) == 2 && thread >= 0
+               && thread < num_threads && number == next[std::size_t(thread)]++;
+    }
+    fmt::print("wait: {}\n", in_order && next == std::array{num_lines, num_lines, num_lines, num_lines});
+    std::fclose(file);
+  }
+
+  // While the file is locked, the queue fills and further lines are dropped and counted.
+  {
+    auto* const file{std::tmpfile()};
+    std::uint64_t num_dropped{};
+    {
+      log_queue queue{file, log_queue::overflow::drop, 4};
+      ::flockfile(file);
+      for (auto line{0}; line != num_lines; ++line) {
+        queue.push(fmt::format("{}\n", line));
+      }
+      num_dropped = queue.num_dropped();
+      ::funlockfile(file);
+    }
+    auto const num_written{read_lines(file).size()};
+    fmt::print("drop: {}, {}\n", num_dropped > 0, num_written + num_dropped == num_lines);
+    std::fclose(file);
+  }
+}
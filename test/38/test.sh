@@ -0,0 +1,20 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: log from several threads at once through a queue, waiting for room or dropping lines when it is full
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="wait: true
+drop: true, true"
+
+ACTUAL=$("${BUILD_DIR}/test/log-queue-example")
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
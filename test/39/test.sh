@@ -0,0 +1,51 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: convert input holding bad tokens with each error policy and get back letters, diagnostics and exit codes
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="AB
+CD
+EFF
+G
+2:3: Unrecognized number, 'X'
+3:3: Out-of-range number, 99
+exit 1
+AB
+C
+2:3: Unrecognized number, 'X'
+exit 1
+AB
+C?D
+E?FF
+G
+2:3: Unrecognized number, 'X'
+3:3: Out-of-range number, 99
+exit 1
+AB?C?D
+1:3: Out-of-range number, 0
+1:5: Out-of-range number, 27
+exit 1
+2:3: Unrecognized number, 'X'
+exit 1"
+
+ACTUAL=$(
+    for policy in skip stop placeholder; do
+        printf '1 2\n3 X 4\n5 99 2x6\n7\n' | "${BUILD_DIR}/src/example-program" --batch --on-error=${policy} 2>&1 \
+            && echo "exit 0" || echo "exit $?"
+    done
+    printf '\x01\x02\x00\x03\x1b\x04' | "${BUILD_DIR}/src/example-program" --batch --format=binary \
+        --on-error=placeholder 2>&1 && echo "exit 0" || echo "exit $?"
+    printf '1 2\n3 X 4\n5 99 2x6\n7\n' | "${BUILD_DIR}/src/example-program" --batch --histogram --threads 4 \
+        --on-error=stop 2>&1 && echo "exit 0" || echo "exit $?"
+)
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
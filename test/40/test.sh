@@ -0,0 +1,27 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: measure the startup latency of a single conversion and get back percentiles
+
+BUILD_DIR="$(pwd)/.."
+
+# Times depend on the machine; only the names are compared.
+EXPECTED="runs 20
+min-ns
+p50-ns
+p90-ns
+p99-ns
+p99.9-ns
+max-ns"
+
+ACTUAL=$("${BUILD_DIR}/benchmark/startup-benchmark" --runs 20 "${BUILD_DIR}/src/example-program" 3 \
+    | sed 's/^\([a-z0-9.-]*-ns\) [0-9]*$/\1/')
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,23 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: the freestanding program fits its size budget and needs no dynamic loader
+
+BUILD_DIR="$(pwd)/.."
+PROGRAM="${BUILD_DIR}/freestanding/src/example-program"
+
+SIZE_BUDGET=16384
+
+EXPECTED="size within budget
+no interpreter"
+ACTUAL="$([ "$(stat -c %s "${PROGRAM}")" -le "${SIZE_BUDGET}" ] && echo "size within budget" || echo "size $(stat -c %s "${PROGRAM}")")
+$(grep -q "ld-linux" "${PROGRAM}" && echo "interpreter" || echo "no interpreter")"
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,39 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: generate the same corpus twice, and a different one, and benchmark batch conversion of it
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+for format in text ndjson csv binary; do
+    "${BUILD_DIR}/benchmark/make-corpus" --format=${format} --bytes 65536 --output "${WORK_DIR}/${format}.1"
+    "${BUILD_DIR}/benchmark/make-corpus" --format=${format} --bytes 65536 --output "${WORK_DIR}/${format}.2"
+    "${BUILD_DIR}/benchmark/make-corpus" --format=${format} --bytes 65536 --seed 2 --output "${WORK_DIR}/${format}.3"
+done
+
+EXPECTED="text same different
+ndjson same different
+csv same different
+binary same different
+exit 1
+runs 3"
+
+ACTUAL="$(for format in text ndjson csv binary; do
+    echo "${format}" \
+        "$(cmp -s "${WORK_DIR}/${format}.1" "${WORK_DIR}/${format}.2" && echo same || echo different)" \
+        "$(cmp -s "${WORK_DIR}/${format}.1" "${WORK_DIR}/${format}.3" && echo same || echo different)"
+done)
+$("${BUILD_DIR}/src/example-program" --batch "${WORK_DIR}/text.1" > /dev/null 2>&1 && echo "exit 0" || echo "exit $?")
+$("${BUILD_DIR}/benchmark/startup-benchmark" --runs 3 --allow-failure "${BUILD_DIR}/src/example-program" --batch \
+    "${WORK_DIR}/text.1" | head -1)"
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,24 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: measure the throughput of the hot paths and get back a line for each
+
+BUILD_DIR="$(pwd)/.."
+
+# Throughputs depend on the machine; only the names are compared.
+EXPECTED="number-to-letter-mps
+find-invalid-position-mps
+positions-to-letters-mps
+sanitize-token-mps"
+
+ACTUAL=$("${BUILD_DIR}/benchmark/throughput-benchmark" --positions 1000 --repeats 2 \
+    | sed 's/^\([a-z-]*-mps\) [0-9]*$/\1/')
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,30 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass runs up to and beyond the longest allowed in batch mode, including runs too long even for int,
+# and get back only the allowed ones
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="1048576 2
+2:1: Out-of-range run length, 1048577 (at most 1048576)
+2:11: Out-of-range run length, 2147483647 (at most 1048576)
+2:28: Out-of-range run length, 99999999999 (at most 1048576)
+2:42: Out-of-range run length, 9999999999999999... (20 bytes) (at most 1048576)
+2:65: Unrecognized number, '-99999999999x3'"
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+printf '1048576x1\n1048577x1 2147483647x2 2x3 99999999999x3 99999999999999999999x3 -99999999999x3\n' \
+    | "${BUILD_DIR}/src/example-program" --batch --echo-limit 16 > "${WORK_DIR}/out" 2> "${WORK_DIR}/err" || true
+ACTUAL="$(awk '{ printf "%s ", length($0) }' "${WORK_DIR}/out" | sed 's/ $//')
+$(cat "${WORK_DIR}/err")"
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,25 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass NDJSON with control characters and quotes in a token and a field name and get back valid JSON and escaped diagnostics
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED='{"n":"1\u0001\\\"X","error":"unrecognized"}
+1:7: Unrecognized number, '"'"'1\x01\\"X'"'"'
+{"p\u001b":null,"error":"unrecognized"}
+1:1: Missing field, '"'"'p\x1b'"'"
+
+set +e
+ACTUAL="$(printf '{"n":"1\x01\\"X"}\n' | "${BUILD_DIR}/src/example-program" --batch --format=ndjson 2>&1)
+$(printf '{"n":1}\n' | "${BUILD_DIR}/src/example-program" --batch --format=ndjson --field "$(printf 'p\x1b')" 2>&1)"
+set -e
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,50 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: convert in batch mode with a tuning file in the default place, which is used unless it is invalid,
+# and with tuning files given by --tuning, of which one with insane values is rejected
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+mkdir -p "${WORK_DIR}/cache/eg-error-handling" "${WORK_DIR}/bad-cache/eg-error-handling"
+printf 'threads 1\nchunk-size 4096\nbuffer-size 4096\nparallel-threshold 4096\n' > "${WORK_DIR}/cache/eg-error-handling/tuning"
+printf 'threads 0\nchunk-size 0\nbuffer-size 0\nparallel-threshold 0\n' > "${WORK_DIR}/bad-cache/eg-error-handling/tuning"
+printf 'threads 2\nchunk-size 4096\nbuffer-size 4096\nparallel-threshold 4096\n' > "${WORK_DIR}/sane"
+printf 'threads 2\nchunk-size 4096\nbuffer-size 1152921504606846976\nparallel-threshold 4096\n' > "${WORK_DIR}/insane"
+
+EXPECTED="HELLO
+exit code 0
+Invalid tuning file, '${WORK_DIR}/bad-cache/eg-error-handling/tuning'; using the defaults
+HELLO
+exit code 0
+HELLO
+exit code 0
+HELLO
+exit code 0
+Invalid tuning file, '${WORK_DIR}/insane'
+Try --help
+exit code 1"
+
+run() {
+    set +e
+    printf '8 5 12 12 15\n' | XDG_CACHE_HOME="${CACHE_HOME:-${WORK_DIR}/cache}" "${BUILD_DIR}/src/example-program" --batch "$@" 2>&1
+    echo "exit code $?"
+    set -e
+}
+
+ACTUAL="$(run)
+$(CACHE_HOME="${WORK_DIR}/bad-cache" run)
+$(run --tuning "${WORK_DIR}/sane")
+$(run --tuning "${WORK_DIR}/missing")
+$(run --tuning "${WORK_DIR}/insane")"
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,58 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: follow a file in batch mode on several threads, so that diagnostics are written by a thread of their own,
+# then stop with SIGTERM and get back every line converted
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+# wait until the output has the given number of lines
+wait_for_lines() {
+    for _ in $(seq 100); do
+        if [ "$(wc -l < "${WORK_DIR}/output.txt")" -ge "$1" ]; then
+            return
+        fi
+        sleep 0.1
+    done
+    echo "FAIL: Timed out waiting for line $1"
+    exit 1
+}
+
+printf '8 5\n' > "${WORK_DIR}/input.txt"
+touch "${WORK_DIR}/output.txt"
+"${BUILD_DIR}/src/example-program" --batch --threads 4 --follow "${WORK_DIR}/input.txt" \
+    --output "${WORK_DIR}/output.txt" 2> "${WORK_DIR}/errors.txt" &
+PID=$!
+wait_for_lines 1
+
+printf '1X\n12 12 15\n' >> "${WORK_DIR}/input.txt"
+wait_for_lines 3
+
+kill -TERM "${PID}"
+set +e
+wait "${PID}"
+EXIT_CODE=$?
+set -e
+
+EXPECTED="HE
+
+LLO
+2:1: Unrecognized number, '1X'"
+
+ACTUAL=$(cat "${WORK_DIR}/output.txt" "${WORK_DIR}/errors.txt")
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+if [ "1" != "$EXIT_CODE" ]; then
+    echo "FAIL: Exit code is $EXIT_CODE"
+    exit 1
+fi
@@ -0,0 +1,33 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: run batch mode with thread counts beyond the limit and get usage errors rather than an abort
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED=""
+ACTUAL=""
+for threads in 0 1025 100000 4000000000 99999999999999999999; do
+    EXPECTED+="Out-of-range thread count, '${threads}' (1 to 1024)
+Try --help
+exit code 1
+"
+    set +e
+    ACTUAL+="$(printf '8 5\n' | "${BUILD_DIR}/src/example-program" --batch --histogram --threads "${threads}" 2>&1)
+exit code $?
+"
+    set -e
+done
+EXPECTED+="HE
+exit code 0"
+ACTUAL+="$(printf '8 5\n' | "${BUILD_DIR}/src/example-program" --batch --threads 1024 2>&1)
+exit code $?"
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,39 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: name files with control characters, or at length, in batch mode
+# and get back error messages which echo the names escaped and in full
+
+BUILD_DIR="$(pwd)/.."
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "${WORK_DIR}"' EXIT
+
+LONG_NAME="${WORK_DIR}/$(printf 'd%.0s' $(seq 100))"
+printf 'threads 0\n' > "${WORK_DIR}/tuning"$'\r'
+
+EXPECTED="Failed to open input file, 'missing\\x1b[2J': No such file or directory
+exit code 1
+Failed to open output file, '${LONG_NAME}/out.txt': No such file or directory
+exit code 1
+Invalid tuning file, '${WORK_DIR}/tuning\\r'
+exit code 1"
+
+run() {
+    set +e
+    "${BUILD_DIR}/src/example-program" --batch "$@" < /dev/null 2>&1 > /dev/null
+    echo "exit code $?"
+    set -e
+}
+
+ACTUAL="$(run "missing"$'\e[2J')
+$(run --output "${LONG_NAME}/out.txt")
+$(run --tuning "${WORK_DIR}/tuning"$'\r')"
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
@@ -0,0 +1,19 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass plain and run-length encoded positions in batch mode and get back expanded letters
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="ABC
+CCCCC"
+ACTUAL=$(printf '1 2 3\n5x3\n' | "${BUILD_DIR}/src/example-program" --batch)
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
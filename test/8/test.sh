@@ -0,0 +1,19 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass runs of positions in batch mode with --rle and get back run-length encoded letters
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="6xCAB
+ZZZ"
+ACTUAL=$(printf '3 3 2x3 2x3 1 2\n3x26\n' | "${BUILD_DIR}/src/example-program" --batch --rle)
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
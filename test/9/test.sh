@@ -0,0 +1,29 @@
+#!/bin/bash
+set -euo pipefail
+
+# Test case: pass bad positions in batch mode and get back located error messages
+
+BUILD_DIR="$(pwd)/.."
+
+EXPECTED="1:3: Out-of-range number, 27
+2:1: Unrecognized number, '4x1X'
+2:6: Out-of-range number, 0"
+
+set +e
+ACTUAL=$(printf '1 27\n4x1X 3x0 2\n' | "${BUILD_DIR}/src/example-program" --batch 2>&1 >/dev/null)
+EXIT_CODE=$?
+set -e
+
+if [ "$EXPECTED" = "$ACTUAL" ]; then
+    echo "PASS: Strings are equal."
+else
+    echo "FAIL: Strings are not equal."
+    echo "Expected: $EXPECTED"
+    echo "Actual: $ACTUAL"
+    exit 1
+fi
+
+if [ "1" != "$EXIT_CODE" ]; then
+    echo "FAIL: Exit code is $EXIT_CODE"
+    exit 1
+fi